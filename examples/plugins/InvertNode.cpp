@@ -0,0 +1,82 @@
+// InvertNode.cpp
+// Example node plugin: inverts every channel of its input
+//
+// Built as a module library (see NODEIMG_BUILD_EXAMPLES in CMakeLists.txt)
+// and loaded from NODEIMG_PLUGIN_PATH, or with --plugins by nodeimg-batch.
+#include "NodeRegistry.hpp"
+#include "PixelKernel.hpp"
+#include <imgui.h>
+
+namespace {
+
+// Integer channels flip around their maximum; float channels around 1.0
+template <typename T, int Channels>
+void invertRows(const cv::Mat& input, cv::Mat& output, float amount) {
+    const float max = static_cast<float>(BaseNode::depthMax(cv::DataType<T>::depth));
+    const int width = input.cols * Channels;
+    forEachRow(input.rows, [&](int y) {
+        const T* in = input.ptr<T>(y);
+        T* out = output.ptr<T>(y);
+        for (int x = 0; x < width; x++) {
+            const float v = static_cast<float>(in[x]);
+            out[x] = cv::saturate_cast<T>(v + amount * (max - 2.0f * v));
+        }
+    });
+}
+
+class InvertNode : public BaseNode {
+public:
+    InvertNode() {
+        name = "Invert";
+        inputs.emplace_back(Pin{0, "Image"});
+        outputs.emplace_back(Pin{1, "Image"});
+    }
+
+    int getPinType(int) const override { return 0; }
+    BaseNode* clone() const override { return new InvertNode(*this); }
+    void serializeParams(ParamArchive& ar) override { ar.field("amount", amount); }
+
+    int tileHalo() const override { return 0; }
+    bool isPointwise() const override { return true; }
+    bool pointwiseLut(int, cv::Mat& lut, bool& toGray) const override {
+        lut.create(1, 256, CV_8U);
+        for (int i = 0; i < 256; i++) {
+            lut.at<unsigned char>(i) = cv::saturate_cast<unsigned char>(i + amount * (255.0f - 2.0f * i));
+        }
+        toGray = false;
+        return true;
+    }
+
+    void process() override {
+        const cv::Mat& input = inputs[0].data;
+        if (input.empty()) return;
+        cv::Mat output(input.size(), input.type());
+        const bool handled = dispatchPixelFormat(input.type(), [&](auto format) {
+            using Format = decltype(format);
+            invertRows<typename Format::Channel, Format::channels>(input, output, amount);
+        });
+        // Formats outside the working precisions go through float
+        if (!handled) {
+            cv::Mat unit;
+            input.convertTo(unit, CV_32F, 1.0 / depthMax(input.depth()));
+            cv::Mat inverted(unit.rows, unit.cols * unit.channels(), CV_32F);
+            invertRows<float, 1>(unit.reshape(1), inverted, amount);
+            inverted = inverted.reshape(unit.channels());
+            inverted.convertTo(output, input.type(), depthMax(input.depth()));
+        }
+        outputs[0].data = output;
+    }
+
+    void drawUI() override {
+        dirty |= ImGui::SliderFloat("Amount", &amount, 0.0f, 1.0f);
+    }
+
+private:
+    float amount = 1.0f;
+};
+
+} // namespace
+
+NODEIMG_PLUGIN(registry) {
+    registry.add<InvertNode>("Invert");
+}
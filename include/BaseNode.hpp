@@ -1,14 +1,51 @@
 // include/BaseNode.hpp
 #pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
 #include <opencv2/opencv.hpp>
+#include "ImageStats.hpp"
+#include "ParamArchive.hpp"
+
+// Conversions of one output's data, made by the first consumer that needs
+// them and shared with every other consumer of that output
+struct PinViews {
+    std::mutex mutex;
+    cv::Mat source; // The data the views were made from
+    cv::Mat gray;
+    cv::Mat color;
+    std::shared_ptr<const ImageStats> stats; // Of gray
+};
 
 struct Pin {
     int id;
     std::string name;
-    cv::Mat data;
+    cv::Mat data; // Shared, reference-counted buffer; never written in place once published
+    cv::UMat gpu; // Device copy for nodes run on the GPU; may be the only copy of an output
     bool connected = false;
+    uint64_t version = 0; // Identifies the content of data for memoization; 0 = unknown
+    bool elided = false;  // Computed inside a fused chain and never stored; data is empty
+
+    // Format: single-channel data that stands for a BGR image with only
+    // this channel set and the others zero; -1 means data is the image
+    int colorChannel = -1;
+    std::shared_ptr<PinViews> views; // Fresh for every computed output; inputs share their producer's
+
+    // data as one channel and as 3/4 channels; returns data itself when it
+    // already has that form and converts (at most once per output) otherwise
+    cv::Mat gray() const;
+    cv::Mat color() const;
+
+    // Histogram, range and mean of gray(), computed once per output like
+    // the conversions (or while tiles are assembled); null without data
+    std::shared_ptr<const ImageStats> stats() const;
+
+    // The BGR image a colorChannel pin stands for
+    static cv::Mat expandChannel(const cv::Mat& data, int channel);
 };
 
 class BaseNode {
@@ -20,9 +57,112 @@ public:
 
     virtual int getPinType(int pinId) const = 0; // Pure virtual method
 
+    // Input pins share their buffer with the upstream output and all other
+    // consumers. Nodes that modify inputs[i].data in place must return true
+    // so the editor hands them a private copy instead.
+    virtual bool mutatesInputs() const { return false; }
+
+    // Copy used for background evaluation. Pin buffers are shared, not copied.
+    virtual BaseNode* clone() const = 0;
+
+    // Takes over the results computed by an evaluated clone of this node.
+    // Nodes that keep derived state besides their pins extend this.
+    virtual void adoptResults(const BaseNode& evaluated);
+
+    // Lists the parameters saved with a graph; see ParamArchive
+    virtual void serializeParams(ParamArchive& ar) {}
+
+    // Tiled evaluation: how many extra input pixels process() reads on each
+    // side of an output pixel. -1 means the node needs whole images (global
+    // statistics, size changes, generators) and is evaluated untiled.
+    virtual int tileHalo() const { return -1; }
+
+    // Memoization: a node whose outputs are a pure function of its
+    // parameters (see serializeParams) and inputs can have them restored
+    // from the ResultCache. Sources and nodes with side effects return false.
+    virtual bool memoizable() const { return true; }
+
+    // Version of an output of a node that is not memoizable, derived from
+    // whatever determines its content (a file's stamp, a frame index, ...),
+    // so equal content keeps its version from pass to pass and downstream
+    // memo keys repeat. 0 when unknown: the output then keeps its version
+    // while it is the same buffer and gets a fresh one otherwise.
+    virtual uint64_t outputVersion(size_t output) const { return 0; }
+
+    // GPU backend: a node that can also run on cv::UMat (OpenCL through
+    // OpenCV's transparent API) implements processGpu(), which reads
+    // inputs[i].gpu and writes outputs[i].gpu. Its results stay on the device
+    // and are downloaded only for consumers that run on the CPU.
+    virtual bool supportsGpu() const { return false; }
+    virtual void processGpu() {}
+
+    // Hash of the node type, the proxy scale, the working depth and every
+    // parameter listed by serializeParams
+    uint64_t paramHash();
+
+    // Pointwise fusion: a single-input, single-output node whose output pixel
+    // depends only on the same input pixel returns true here. Runs of such
+    // nodes are evaluated in one pass, with only the last output stored.
+    virtual bool isPointwise() const { return false; }
+
+    // For 8-bit input with the given channel count, fills lut (256 x CV_8U)
+    // with the node's mapping. toGray is set when the node converts 3-channel
+    // input to gray before applying it. False means the node must run itself.
+    virtual bool pointwiseLut(int channels, cv::Mat& lut, bool& toGray) const { return false; }
+
+    // Output format (see Pin::colorChannel): an output that holds one
+    // channel of a color image returns which one, so that it is only
+    // expanded where a consumer needs the color image
+    virtual int outputColorChannel(size_t output) const { return -1; }
+
+    // Nodes that read Pin::stats() of their inputs in process() return true,
+    // so tiled evaluation gathers them while it assembles those inputs
+    virtual bool readsInputStats() const { return false; }
+    // Nodes whose UI shows their input or its statistics return true; in a
+    // fused chain their input is then still produced for the editor
+    virtual bool showsInput() const { return false; }
+
+    // Seconds from now (ImGui::GetTime()) until the node's UI has to be drawn
+    // again without any input, such as the next step of a playing sequence;
+    // negative when it only changes on input or finished evaluations
+    virtual double redrawIn(double now) const { return -1.0; }
+
+    // Nodes that handle Pin::colorChannel inputs themselves return true;
+    // all others are handed the expanded color image instead
+    virtual bool readsChannelViews() const { return false; }
+
+    // Proxy evaluation: full-resolution size of the image a source node
+    // feeds into the graph, empty for nodes that only transform their inputs
+    virtual cv::Size sourceSize() const { return cv::Size(); }
+
+    // Value standing for full intensity: 255 and 65535 for the integer
+    // depths, 1.0 for floating point
+    static double depthMax(int depth);
+
+    // image at the given depth, its value range rescaled to match; image
+    // itself when it is at that depth already
+    static cv::Mat convertDepth(const cv::Mat& image, int depth);
+
+    // A length in full-resolution pixels converted to the current proxyScale
+    int proxyPixels(int pixels, int minimum = 1) const {
+        return std::max(minimum, static_cast<int>(std::lround(pixels * proxyScale)));
+    }
+
     std::vector<Pin> inputs;
     std::vector<Pin> outputs;
     std::string name;
     int id;
-    bool dirty = true;
+    bool dirty = true; // Set on parameter/link edits; processGraph() recomputes dirty nodes and their consumers
+    bool frozen = false; // "Cache to disk": outputs are kept in the DiskCache and upstream edits are ignored
+
+    // Resolution the outputs are computed at, relative to the source images:
+    // 1 for final results, a power of two fraction (1/2, 1/4, ...) while the
+    // editor shows interactive proxies. Sources downscale their images by it
+    // and nodes with parameters in pixels scale those to match.
+    double proxyScale = 1.0;
+
+    // Graph-wide working precision, CV_8U, CV_16U or CV_32F (see
+    // NodeEditor::setWorkingDepth). Sources produce their images at it;
+    // every other node keeps the depth of its input.
+    int workingDepth = CV_8U;
 };
@@ -0,0 +1,70 @@
+// include/BufferPool.hpp
+#pragma once
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Process-wide cv::MatAllocator that recycles image buffers.
+ *
+ * Every evaluation pass allocates the same set of outputs and temporaries
+ * as the previous one. With the default allocator each of them is a fresh
+ * mapping that is faulted in page by page and unmapped again at the end.
+ * Once installed, buffers of kMinPooledBytes and more are kept when their
+ * last cv::Mat goes away and handed out again for the next request of the
+ * same byte size. Idle buffers are bounded by a budget; smaller buffers go
+ * straight to cv::fastMalloc.
+ *
+ * The pool also tracks the bytes held by all live cv::Mat buffers, so the
+ * editor can report the peak working set of a pass.
+ */
+class BufferPool : public cv::MatAllocator {
+public:
+    static constexpr size_t kMinPooledBytes = 64 * 1024;
+
+    static BufferPool& instance();
+
+    // Makes the pool the default allocator of cv::Mat. Call before images
+    // are created; buffers that already exist keep their own allocator.
+    static void install();
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override;
+    bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags,
+                  cv::UMatUsageFlags usageFlags) const override;
+    void deallocate(cv::UMatData* data) const override;
+
+    struct Stats {
+        size_t inUse = 0; // Bytes of live buffers, pooled or not
+        size_t peak = 0;  // Largest inUse since resetPeak()
+        size_t idle = 0;  // Bytes waiting in the pool for reuse
+        uint64_t reused = 0;
+        uint64_t allocated = 0; // Pooled-size requests that needed new memory
+    };
+    Stats stats() const;
+    void resetPeak(); // Restarts peak tracking from the current usage
+
+    void setIdleBudget(size_t bytes);
+    size_t idleBudget() const;
+    void trim(); // Frees every idle buffer
+
+private:
+    BufferPool() = default;
+
+    void* acquire(size_t bytes) const;
+    void release(void* buffer, size_t bytes) const;
+
+    mutable std::mutex mutex;
+    mutable std::unordered_map<size_t, std::vector<void*>> idle; // By exact byte size
+    mutable size_t idleBytes = 0;
+    size_t budgetBytes = size_t(512) * 1024 * 1024;
+    mutable uint64_t reusedCount = 0;
+    mutable uint64_t allocatedCount = 0;
+
+    mutable std::atomic<size_t> inUseBytes{0};
+    mutable std::atomic<size_t> peakBytes{0};
+};
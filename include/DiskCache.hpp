@@ -0,0 +1,75 @@
+// include/DiskCache.hpp
+#pragma once
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * On-disk results of frozen nodes ("Cache to disk"), reused across sessions.
+ *
+ * Each output of a frozen node is stored as one raw file: a small header
+ * followed by the pixels, row after row, starting at a page boundary.
+ * Reading maps the file and wraps the mapping as a cv::Mat directly, with
+ * no decode and no copy; pages are faulted in only as they are read, and
+ * the mapping is released with the last cv::Mat sharing it. The mapping is
+ * private, so the file never changes through a cv::Mat.
+ *
+ * Files are named after the node id and validated against a key, which the
+ * editor derives from the node's parameters. A frozen node with valid files
+ * ignores changes upstream of it until it is unfrozen.
+ *
+ * One directory per process, normally placed next to the saved graph.
+ */
+class DiskCache {
+public:
+    static constexpr uint32_t kFormatVersion = 1;
+
+    static DiskCache& instance();
+
+    // Raw file access; content is an id identifying the pixels, which the
+    // editor uses as the output's version
+    static bool writeRaw(const std::string& path, const cv::Mat& image, uint64_t key, uint64_t content);
+    static bool readHeader(const std::string& path, uint64_t& key, uint64_t& content);
+    static cv::Mat mapRaw(const std::string& path, uint64_t& key, uint64_t& content);
+
+    // Directory for a graph saved at graphPath: "<dir>/<stem>.cache"
+    static std::string directoryFor(const std::string& graphPath);
+    void setDirectory(const std::string& dir);
+    std::string directory() const;
+
+    // Switches to dir, first copying the files of the given nodes over so
+    // that a graph saved elsewhere keeps its frozen results
+    void relocate(const std::string& dir, const std::vector<int>& nodeIds);
+
+    // True if every one of the node's outputs is stored under key. The
+    // answer is remembered per node and key until the node's files are
+    // stored, removed or fail to load, or the directory changes, so passes
+    // do not read headers again for nodes whose parameters did not change.
+    bool has(int nodeId, size_t outputCount, uint64_t key) const;
+    // Maps all outputs; false if any of them is missing or stored under another key
+    bool load(int nodeId, size_t outputCount, uint64_t key,
+              std::vector<cv::Mat>& outputs, std::vector<uint64_t>& contents) const;
+    // Writes all outputs; contents receives the id stored for each
+    bool store(int nodeId, uint64_t key, const std::vector<cv::Mat>& outputs,
+               std::vector<uint64_t>& contents) const;
+    void remove(int nodeId, size_t outputCount) const;
+
+private:
+    DiskCache() = default;
+    std::string pathFor(int nodeId, size_t output) const;
+
+    struct Check {
+        uint64_t key;
+        size_t outputCount;
+        bool valid;
+    };
+    void remember(int nodeId, size_t outputCount, uint64_t key, bool valid) const;
+    void forget(int nodeId) const;
+
+    std::string dir = "nodeimg_cache";
+    mutable std::unordered_map<int, Check> checked; // Last has() answer per node
+    mutable std::mutex mutex;
+};
@@ -0,0 +1,42 @@
+// include/FilterKernel.hpp
+#pragma once
+#include <opencv2/core.hpp>
+
+/**
+ * A 2-D correlation kernel prepared once and applied many times.
+ *
+ * On construction the kernel is factored with an SVD. A kernel of rank one
+ * (box, Gaussian, identity, ...) is applied as a row pass followed by a
+ * column pass, which costs 2n instead of n^2 operations per pixel. Other
+ * kernels are applied directly while they are small, and through the DFT
+ * from kDftMinSize on; the kernel's spectrum is kept for the image size it
+ * was last computed for.
+ *
+ * The anchor is always the kernel centre, as with cv::filter2D. Output has
+ * the input's type, saturated for integer depths.
+ */
+class FilterKernel {
+public:
+    static constexpr int kDftMinSize = 15; // Kernel width from which the DFT path is used
+
+    FilterKernel() = default;
+    explicit FilterKernel(const cv::Mat& kernel); // Square, odd-sized, single channel
+
+    bool empty() const { return dense.empty(); }
+    bool separable() const { return !rowKernel.empty(); }
+    int size() const { return dense.cols; }
+
+    void apply(const cv::Mat& input, cv::Mat& output, int borderType);
+    // The device path has no DFT variant; dense kernels use cv::filter2D
+    void apply(const cv::UMat& input, cv::UMat& output, int borderType) const;
+
+private:
+    void applyDft(const cv::Mat& input, cv::Mat& output, int borderType);
+
+    cv::Mat dense;        // CV_32F
+    cv::Mat rowKernel;    // 1 x n, applied along each row; empty unless separable
+    cv::Mat columnKernel; // n x 1
+
+    cv::Mat spectrum;     // DFT of dense, zero-padded to spectrumSize
+    cv::Size spectrumSize;
+};
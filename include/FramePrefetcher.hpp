@@ -0,0 +1,85 @@
+// include/FramePrefetcher.hpp
+#pragma once
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Decodes the frames of a video or numbered image sequence ahead of the
+ * frame being shown.
+ *
+ * Sources are either a file cv::VideoCapture can open or a printf-style
+ * pattern such as "shot_%04d.png". Worker threads keep the next kAhead
+ * frames, starting at the most recently requested one, decoded in a ring,
+ * so playback overlaps decoding with graph evaluation instead of decoding
+ * inside process(). A few frames behind the current one are kept for
+ * scrubbing back. Numbered images are decoded in parallel; a video is read
+ * by one worker, in order, since seeking it is expensive.
+ *
+ * Once opened, all methods are thread-safe; evaluation clones share one
+ * prefetcher with the live node. Decoded frames are read-only.
+ */
+class FramePrefetcher {
+public:
+    static constexpr int kAhead = 8;
+    static constexpr int kBehind = 2;
+
+    FramePrefetcher() = default;
+    ~FramePrefetcher();
+    FramePrefetcher(const FramePrefetcher&) = delete;
+    FramePrefetcher& operator=(const FramePrefetcher&) = delete;
+
+    // Turns a file of a numbered sequence ("shot_0012.png") into its pattern
+    // ("shot_%04d.png"); anything else is returned unchanged
+    static std::string patternFor(const std::string& path);
+
+    bool open(const std::string& source);
+    const std::string& source() const { return sourcePath; }
+    int frameCount() const { return count; }
+    double fps() const { return rate; }
+
+    // Moves the decode window so that it starts at index
+    void seek(int index);
+    // A frame asked about here that is not decoded yet is awaited: the
+    // callback set below runs once it arrives
+    bool ready(int index) const;
+    // Seeks to index and waits for its frame; empty if it cannot be decoded
+    cv::Mat frame(int index);
+
+    // Called on a decoding thread when an awaited frame is decoded, for all
+    // prefetchers; lets a UI that sleeps while idle resume playback. Set
+    // before any prefetcher is opened.
+    static void setOnAwaitedFrame(std::function<void()> callback);
+
+private:
+    void stop();
+    void workerLoop();
+    int nextToDecodeLocked() const;
+    cv::Mat decode(int index);
+
+    std::string sourcePath;
+    std::string pattern;  // Sequences only
+    int firstNumber = 0;  // File number of frame 0
+    int count = 0;
+    double rate = 24.0;
+
+    cv::VideoCapture capture; // Videos only; used by the single worker
+    int capturePosition = 0;  // Frame index the next read returns
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;    // Workers: the window moved or stop
+    std::condition_variable decoded; // Readers: a frame arrived
+    std::map<int, cv::Mat> frames;   // Decoded frames in the window
+    std::set<int> inFlight;
+    int windowStart = 0;
+    mutable int awaited = -1; // Frame the last ready() call missed
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
@@ -0,0 +1,36 @@
+// include/GLPreviewTexture.hpp
+#pragma once
+#include "PreviewTexture.hpp"
+#include <GL/glew.h>
+#include <array>
+
+// OpenGL implementation of PreviewTexture, only linked into the GUI executable.
+// The texture is reallocated only when the image size or format changes;
+// pixels are streamed through a small ring of pixel buffer objects so the
+// copy into driver memory never waits for the previous transfer to finish.
+class GLPreviewTexture : public PreviewTexture {
+public:
+    GLPreviewTexture();
+    ~GLPreviewTexture() override;
+
+    GLPreviewTexture(const GLPreviewTexture&) = delete;
+    GLPreviewTexture& operator=(const GLPreviewTexture&) = delete;
+
+    void upload(const cv::Mat& image) override;
+    ImTextureID id() const override;
+
+private:
+    static constexpr size_t kBuffers = 3;
+
+    void allocate(int width, int height, int channels, int depth);
+
+    GLuint textureID = 0;
+    std::array<GLuint, kBuffers> pixelBuffers{};
+    size_t nextBuffer = 0;
+
+    // Current texture storage
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    int depth = -1;
+};
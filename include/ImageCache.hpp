@@ -0,0 +1,73 @@
+// include/ImageCache.hpp
+#pragma once
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Process-wide cache of decoded images shared by every ImageInputNode.
+ *
+ * Entries are keyed by path and validated against the file's modification
+ * time and size, so a file is decoded once and only decoded again after it
+ * changes on disk. Total pixel memory is bounded by a configurable budget;
+ * the least recently used entries are evicted first.
+ *
+ * Returned images share their buffer with the cache and must be treated as
+ * read-only.
+ */
+class ImageCache {
+public:
+    struct Stamp {
+        int64_t mtime = 0;
+        uintmax_t size = 0;
+        bool operator==(const Stamp& other) const {
+            return mtime == other.mtime && size == other.size;
+        }
+        bool operator!=(const Stamp& other) const { return !(*this == other); }
+    };
+
+    static ImageCache& instance();
+
+    // Returns the decoded image for path (empty on failure). If stamp is given
+    // it receives the file state the returned image corresponds to.
+    cv::Mat load(const std::string& path, Stamp* stamp = nullptr);
+
+    // True if the file no longer matches the stamp it was loaded with
+    static bool hasChanged(const std::string& path, const Stamp& stamp);
+    static bool readStamp(const std::string& path, Stamp& stamp);
+
+    // Lookups made by the calling thread so far. The profiler attributes the
+    // difference across a process() call to the node that made it.
+    struct Counters {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+    static Counters threadCounters();
+
+    void setBudget(size_t bytes);
+    size_t budget() const;
+    size_t usage() const;
+    void clear();
+
+private:
+    ImageCache() = default;
+
+    struct Entry {
+        std::string path;
+        Stamp stamp;
+        cv::Mat image;
+        size_t bytes = 0;
+    };
+
+    void evictLocked();
+
+    std::list<Entry> lru; // Front is the most recently used entry
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    size_t budgetBytes = size_t(1024) * 1024 * 1024; // 1 GB by default
+    size_t usedBytes = 0;
+    mutable std::mutex mutex;
+};
@@ -0,0 +1,71 @@
+// include/ImageEncoder.hpp
+#pragma once
+#include "BoundedQueue.hpp"
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Background image writer shared by the editor and the batch runner.
+ *
+ * Each submitted image is encoded and written on one of the encoder
+ * threads; OpenCV's codecs are single-threaded per image, so several
+ * threads let independent images and outputs encode side by side. The
+ * queue is bounded: submit() blocks once that many images are waiting,
+ * which keeps a fast producer from piling up finished frames in memory.
+ *
+ * Images are shared, not copied; callers must not write into them after
+ * submitting, which holds for pin data since nodes never modify inputs.
+ */
+class ImageEncoder {
+public:
+    struct Job {
+        std::string path;
+        cv::Mat image;
+        std::vector<int> params; // cv::imwrite parameters
+    };
+
+    explicit ImageEncoder(unsigned threads = 2, size_t queueCapacity = 0);
+    ~ImageEncoder(); // Finishes every queued job
+    ImageEncoder(const ImageEncoder&) = delete;
+    ImageEncoder& operator=(const ImageEncoder&) = delete;
+
+    // Encoder used by the editor's Output nodes
+    static ImageEncoder& shared();
+
+    // OpenCV 4.2 and later only read and write OpenEXR when
+    // OPENCV_IO_ENABLE_OPENEXR is set. Float graphs depend on it, so the
+    // executables call this first thing, before any image is decoded; a
+    // value the user set already is kept.
+    static void enableOpenExr();
+
+    // Creates missing parent directories; the future reports whether the file was written
+    std::future<bool> submit(Job job);
+
+    // Called on an encoder thread after each job, so a waiting UI can redraw
+    // the save status. Set before the first submit.
+    void setOnJobDone(std::function<void()> callback) { onJobDone = std::move(callback); }
+
+    // Blocks until everything submitted so far has been written; no further submits
+    void finish();
+
+    int failures() const { return failed.load(); }
+
+private:
+    struct Pending {
+        Job job;
+        std::promise<bool> done;
+    };
+
+    void workerLoop();
+    static bool write(const Job& job);
+
+    BoundedQueue<Pending> queue;
+    std::vector<std::thread> workers;
+    std::atomic<int> failed{0};
+    std::function<void()> onJobDone;
+};
@@ -0,0 +1,46 @@
+// include/ImageStats.hpp
+#pragma once
+#include <opencv2/core.hpp>
+#include <array>
+#include <cstdint>
+
+/**
+ * Histogram, range and mean of a gray image, gathered in one pass.
+ *
+ * Computed at most once per output through Pin::stats() and shared by every
+ * consumer, so Otsu thresholding and the histograms shown in the editor
+ * read the same numbers instead of each scanning the image again. The pass
+ * is split into row stripes on OpenCV's workers; partial results merge
+ * exactly, which also lets tiled evaluation gather them tile by tile.
+ *
+ * The 256 bins span the full range of the depth: one value per bin for
+ * 8 bits, 256 values for 16 bits and 1/256 for float, where values outside
+ * 0..1 land in the first and last bins. min, max and mean are exact.
+ */
+struct ImageStats {
+    static constexpr int kBins = 256;
+
+    std::array<uint64_t, kBins> histogram{};
+    uint64_t count = 0; // Pixels counted; NaNs are skipped
+    double sum = 0.0;
+    double min = 0.0;   // Both 0 while count is 0
+    double max = 0.0;
+    int depth = CV_8U;  // Of the image the bins refer to; deeper formats are counted as float
+
+    // gray must have one channel
+    static ImageStats of(const cv::Mat& gray);
+    // Adds the statistics of another part of the same image
+    void merge(const ImageStats& other);
+
+    double mean() const { return count ? sum / count : 0.0; }
+    // Extent of one bin in image values
+    double binWidth() const;
+
+    // Otsu's threshold in image values: pixels above it are foreground. For
+    // 8-bit images it is the one cv::THRESH_OTSU picks; deeper images are
+    // split at a bin edge.
+    double otsuThreshold() const;
+
+    // Bin counts relative to the tallest bin, for plotting
+    std::array<float, kBins> normalized() const;
+};
@@ -1,29 +1,34 @@
 // include/NodeEditor.hpp
 #pragma once
 #include "BaseNode.hpp"
+#include "NodeProfiler.hpp"
+#include "ResultCache.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>  
 
-// Forward declarations instead of node headers
-enum class NodeType {
-    ImageInput,
-    Output,
-    BrightnessContrast,
-    ColorChannelSplitter,
-    Blur,
-    Threshold,
-    EdgeDetection,
-    Blend,
-    Noise,
-    Convolution
-};
+class ThreadPool;
 
 class NodeEditor {
 public:
     NodeEditor();
-    ~NodeEditor();
+    ~NodeEditor(); // Calls shutdown()
+
+    // Stops the background evaluator, waiting for a pass in flight, and
+    // drops the graph. Afterwards no callback runs and no node (with its
+    // preview texture) is left, so a UI calls this before tearing down its
+    // GL context. Nothing is evaluated asynchronously after it.
+    void shutdown();
 
     struct Connection {
         int inputNode;
@@ -39,27 +44,189 @@ public:
     bool isConnectionValid(const Connection& conn);
     void deleteConnection(int linkId);
     void drawProperties();
+    void drawProfiler();
     BaseNode* findNodeById(int nodeId);
-    int findPinIndex(const std::vector<Pin>& pins, int pinId);
+    static int findPinIndex(const std::vector<Pin>& pins, int pinId);
     
+    // Evaluates every dirty node and its consumers, blocking until done
      void processGraph();
-    void processNode(BaseNode* node, std::unordered_set<BaseNode*>& processed);
+
+    // Evaluates the whole graph tile by tile (see TiledEvaluator), blocking
+    // until done. Peak memory follows the tile size rather than the image size.
+    void processGraphTiled(int tileSize);
+
+    // Non-blocking variant for the UI loop: swaps in the results of a finished
+    // background evaluation, then submits a snapshot of the graph if anything
+    // changed. A newer submission cancels the evaluation still in flight.
+    void evaluateAsync();
+    bool isEvaluating() const;
+
+    // For a UI loop that sleeps while idle. The callback runs on the
+    // evaluator thread whenever a finished evaluation is ready to swap in,
+    // and must only wake the UI thread. Set before the first evaluateAsync().
+    void setOnResultsReady(std::function<void()> callback) { onResultsReady = std::move(callback); }
+    // Seconds until the UI has to draw again without further input: when the
+    // full-resolution pass after proxy previews is due, or the earliest
+    // BaseNode::redrawIn(). Negative when nothing is scheduled, including
+    // while an evaluation runs, whose completion is signalled through the
+    // callback instead.
+    double idleTimeout() const;
+
+    // Interactive proxies: passes started by edits in evaluateAsync() see
+    // their sources halved until one more halving would make the widest
+    // narrower than this, so their cost follows the preview size rather
+    // than the image size. Once edits pause for kRefineDelay, a
+    // full-resolution pass replaces the proxies. 0 always uses full size.
+    static constexpr int kDefaultProxyWidth = 600; // Twice the 300 px preview
+    static constexpr std::chrono::milliseconds kRefineDelay{250};
+    void setProxyWidth(int pixels) { proxyWidth = std::max(pixels, 0); }
+    int getProxyWidth() const { return proxyWidth; }
+
+    // Working precision of the whole graph: CV_8U, CV_16U or CV_32F (0..1).
+    // Sources decode and generate at this depth and every node processes
+    // its input at the depth it arrives in, so a 16-bit or float graph is
+    // not rounded to 8 bits anywhere on the way to its Output nodes.
+    // Changing it re-evaluates everything.
+    void setWorkingDepth(int depth);
+    int getWorkingDepth() const { return workingDepth; }
+
     void clear();
 
-    template <NodeType T>
-    void addNode();
+    // Number of threads used to evaluate independent branches (0 = all cores)
+    void setWorkerCount(unsigned count);
+    unsigned getWorkerCount() const;
+
+    // Runs nodes that support it on the GPU through OpenCL (see
+    // BaseNode::processGpu). Has no effect when no OpenCL device is present.
+    static bool isGpuAvailable();
+    void setGpuEnabled(bool enabled);
+    bool isGpuEnabled() const { return useGpu.load(std::memory_order_relaxed); }
+
+    // Outputs are normally kept after a pass, so the next edit recomputes
+    // only what it affects. Without retention, an output recomputed because
+    // its inputs changed is dropped as soon as its last consumer has run,
+    // and its buffer is reused within the same pass (see BufferPool). Meant
+    // for batch runs, where every frame changes the input anyway.
+    void setRetainIntermediates(bool retain) { retainIntermediates.store(retain, std::memory_order_relaxed); }
+
+    // Adds a node of a type known to the NodeRegistry, by its name
+    // ("Blur", "Noise Generator", ...); null for unknown types
+    BaseNode* addNode(const std::string& typeName);
+
+    // Links an output pin to an input pin by id, as dragging a link in the
+    // editor does. False if either pin does not exist.
+    bool connect(int outputPin, int inputPin);
+
+    const std::vector<std::unique_ptr<BaseNode>>& getNodes() const { return nodes; }
+    NodeProfiler& getProfiler() { return profiler; }
+    ResultCache& getResultCache() { return memo; }
 
 private:
+    friend class GraphSerializer;
+    friend class TiledEvaluator;
 
 
     std::vector<std::unique_ptr<BaseNode>> nodes;
     std::vector<Connection> connections;
     int currentId = 0;
     BaseNode* selectedNode = nullptr;
+    std::shared_ptr<ThreadPool> pool;
+    NodeProfiler profiler;
+    ResultCache memo; // Shared by the live graph and its evaluation snapshots
+    std::atomic<bool> useGpu{false};
+    std::atomic<bool> retainIntermediates{true};
+    int proxyWidth = kDefaultProxyWidth;
+    int workingDepth = CV_8U;
+    NodeProfiler::Clock::time_point lastEdit; // Of the last change evaluateAsync() saw
 
-    
+    // Where a pin lives: owning node index and position in its pin vector
+    struct PinLocation {
+        size_t node;
+        int pin;
+        bool isInput;
+    };
+
+    // Where a node runs, and whether its outputs must exist in host memory
+    // (a CPU consumer reads them, or nothing does yet) or may stay on the GPU
+    struct Placement {
+        bool gpu = false;
+        bool hostOutputs = true;
+        bool fromDisk = false; // Frozen with valid files: outputs are mapped from the DiskCache
+        bool toDisk = false;   // Frozen, computed at full resolution: outputs are written to it
+    };
+
+    // One connection as seen from the consuming node, fully resolved to indices
+    struct InputLink {
+        size_t producer; // Index of the producing node
+        int outputPin;   // Index into the producer's outputs
+        int inputPin;    // Index into the consumer's inputs
+    };
+
+    // Adjacency over node indices plus a topological order. Rebuilt only when
+    // nodes or links are added or removed, and shared read-only with jobs.
+    struct Topology {
+        std::vector<std::vector<InputLink>> incoming; // Per node
+        std::vector<std::vector<size_t>> outgoing;    // Consumer indices per node, one per link
+        std::vector<size_t> order;                    // Nodes that are part of a cycle are omitted
+    };
+
+    std::unordered_map<int, size_t> nodeIndex;     // Node id -> index in nodes
+    std::unordered_map<int, PinLocation> pinIndex; // Pin id -> location
+    std::shared_ptr<const Topology> topology;      // Null when stale
+
+    // A copy of the graph evaluated off the UI thread. Node clones share pin
+    // buffers with the live graph, so taking a snapshot copies no pixels.
+    struct EvaluationJob {
+        uint64_t generation = 0;
+        double scale = 1.0; // proxyScale of every node in the snapshot
+        std::vector<std::unique_ptr<BaseNode>> nodes;
+        std::shared_ptr<const Topology> topology;
+        std::vector<int> processed; // Ids of the nodes that were recomputed
+        std::atomic<bool> cancelled{false};
+    };
+
+    std::thread evaluator;
+    mutable std::mutex jobMutex;
+    std::condition_variable jobReady;
+    std::unique_ptr<EvaluationJob> pendingJob;   // Submitted, not started yet
+    EvaluationJob* runningJob = nullptr;         // Owned by the evaluator thread
+    std::unique_ptr<EvaluationJob> completedJob; // Finished, waiting to be swapped in
+    bool stopEvaluator = false;
+    std::function<void()> onResultsReady;
+    uint64_t latestGeneration = 0;
+    std::unordered_set<int> unresolvedDirty; // Dirty nodes whose results are not swapped in yet
+
+    void evaluatorLoop();
+    void collectResults();
+    double proxyScaleFor() const;
+    void useFullResolution(); // Marks nodes holding proxy results dirty
+    void pruneConnections();
+    void indexNode(size_t idx);
+    void rebuildIndex();
+    void invalidateTopology() { topology.reset(); }
+    // Builds the topology if stale
+    std::shared_ptr<const Topology> currentTopology();
+    void evaluateGraph(std::vector<std::unique_ptr<BaseNode>>& graphNodes,
+                       const Topology& graphTopology,
+                       const std::atomic<bool>* cancelled,
+                       std::vector<int>* processedIds);
+    static void processNode(BaseNode* node,
+                            const std::vector<InputLink>& links,
+                            const std::vector<std::unique_ptr<BaseNode>>& graphNodes,
+                            NodeProfiler* profiler,
+                            ResultCache* memo,
+                            Placement placement);
+    static void processChain(const std::vector<size_t>& chain,
+                             const Topology& graph,
+                             const std::vector<std::unique_ptr<BaseNode>>& graphNodes,
+                             NodeProfiler* profiler,
+                             ResultCache* memo);
+    static uint64_t memoKey(BaseNode* node, const ResultCache* memo);
+    static uint64_t frozenKey(BaseNode* node);
+    static void restoreFrozen(BaseNode* node, NodeProfiler* profiler);
+    void setFrozen(BaseNode* node, bool frozen);
     void handleConnections();
     void handleDeletion();
     BaseNode* findNodeByPin(int pinId, bool isInput);
-    BaseNode* createNode(NodeType type);
+    BaseNode* createNode(const std::string& typeName);
 };
\ No newline at end of file
@@ -0,0 +1,93 @@
+// include/NodeProfiler.hpp
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * Collects per-node timing and memory statistics for the editor.
+ *
+ * Every process() call is recorded from whichever worker ran it, so all
+ * methods are thread-safe. Statistics are keyed by node id; evaluation
+ * clones share the id of the live node, so their calls count for it.
+ * When tracing is enabled, calls are also kept as events that can be
+ * exported in Chrome's trace format (chrome://tracing, Perfetto).
+ */
+class NodeProfiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct NodeStats {
+        std::string name;
+        uint64_t calls = 0;
+        double lastMs = 0.0;
+        double meanMs = 0.0;
+        double p95Ms = 0.0;    // Over the most recent calls
+        size_t outputBytes = 0; // Of the last call
+        uint64_t cacheHits = 0;
+        uint64_t cacheMisses = 0;
+    };
+
+    // One evaluation pass over the graph
+    struct PassStats {
+        double wallMs = 0.0;
+        double nodeMs = 0.0; // Sum over nodes; exceeds wallMs when branches overlap
+        size_t nodes = 0;
+        size_t peakBytes = 0; // Largest image working set while the pass ran
+    };
+
+    void record(int nodeId, const std::string& name, Clock::time_point start,
+                Clock::time_point end, size_t outputBytes,
+                uint64_t cacheHits, uint64_t cacheMisses);
+    void recordPass(Clock::time_point start, Clock::time_point end, size_t peakBytes);
+
+    bool stats(int nodeId, NodeStats& out) const;
+    std::vector<std::pair<int, NodeStats>> snapshot() const;
+    PassStats lastPass() const;
+
+    void forget(int nodeId);
+    void clear();
+
+    void setTracing(bool enabled);
+    bool tracing() const { return tracingEnabled.load(std::memory_order_relaxed); }
+    size_t traceEventCount() const;
+    bool exportTrace(const std::string& path) const;
+
+private:
+    static constexpr size_t kWindow = 128;       // Samples kept for p95
+    static constexpr size_t kMaxEvents = 200000; // Oldest trace events are dropped first
+
+    struct Series {
+        NodeStats stats;
+        std::array<float, kWindow> samples{};
+        size_t next = 0;
+    };
+
+    struct TraceEvent {
+        std::string name;
+        int nodeId;
+        int64_t startUs;
+        int64_t durationUs;
+        int thread;
+    };
+
+    int threadNumberLocked(std::thread::id thread);
+
+    mutable std::mutex mutex;
+    std::unordered_map<int, Series> series;
+    PassStats pass;
+    PassStats running; // Accumulates node time until recordPass()
+    std::atomic<bool> tracingEnabled{false};
+    std::deque<TraceEvent> events;
+    std::unordered_map<std::thread::id, int> threadNumbers;
+    const Clock::time_point epoch = Clock::now();
+};
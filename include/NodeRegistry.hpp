@@ -0,0 +1,88 @@
+// include/NodeRegistry.hpp
+#pragma once
+#include "BaseNode.hpp"
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * The node types the editor, the graph files and the batch runner know.
+ *
+ * Built-in nodes are registered when the registry is first used; further
+ * types come from plugins, shared libraries loaded at startup. A node type
+ * is a BaseNode subclass and declares everything the engine needs through
+ * it: pins in its constructor, parameters through serializeParams(), and
+ * its traits (isPointwise/pointwiseLut, tileHalo, memoizable, supportsGpu,
+ * outputColorChannel, ...) through the virtuals. Kernels can be specialized
+ * per pixel format with dispatchPixelFormat() from PixelKernel.hpp.
+ *
+ * A plugin is built against the same headers and compiler as the host and
+ * defines one entry point:
+ *
+ *     NODEIMG_PLUGIN(registry) {
+ *         registry.add<InvertNode>("Invert");
+ *     }
+ *
+ * It links against nothing of the node library; the host executables export
+ * their symbols (ENABLE_EXPORTS), which the plugin resolves when loaded.
+ *
+ * Registration is not thread-safe: types are added at startup, before any
+ * graph is built. Plugins stay loaded until the process exits, since the
+ * code of their nodes lives in them.
+ */
+class NodeRegistry {
+public:
+    // Bumped whenever BaseNode or this interface changes incompatibly
+    static constexpr int kApiVersion = 1;
+
+    using Factory = std::function<BaseNode*()>;
+
+    struct Entry {
+        std::string name;   // BaseNode::name of the nodes it creates; identifies the type in graph files
+        std::string label;  // Menu text
+        Factory create;
+        std::string origin; // Plugin the type came from; empty for built-in nodes
+    };
+
+    static NodeRegistry& instance();
+
+    // False, with a message, if a type of the same name exists already
+    bool add(const std::string& label, Factory create);
+    template <typename Node>
+    bool add(const std::string& label) {
+        return add(label, [] { return static_cast<BaseNode*>(new Node()); });
+    }
+
+    const Entry* find(const std::string& name) const;
+    const std::vector<Entry>& entries() const { return types; }
+    // Null for unknown names
+    BaseNode* create(const std::string& name) const;
+
+    // Loads one plugin library, or every library in a directory
+    bool loadPlugin(const std::string& path);
+    // Each entry of a search path (':'-separated, ';' on Windows); returns
+    // the number of plugins loaded
+    int loadPlugins(const std::string& searchPath);
+    // $NODEIMG_PLUGIN_PATH, or empty
+    static std::string defaultSearchPath();
+
+private:
+    NodeRegistry(); // Registers the built-in nodes
+    bool loadLibrary(const std::string& path);
+
+    std::vector<Entry> types;
+    std::string loadingOrigin; // Library being registered by loadLibrary()
+};
+
+#if defined(_WIN32)
+#define NODEIMG_PLUGIN_EXPORT extern "C" __declspec(dllexport)
+#else
+#define NODEIMG_PLUGIN_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+// Defines a plugin's entry points; the body registers its node types
+#define NODEIMG_PLUGIN(registry)                                        \
+    NODEIMG_PLUGIN_EXPORT int nodeimg_plugin_api_version() {            \
+        return NodeRegistry::kApiVersion;                               \
+    }                                                                   \
+    NODEIMG_PLUGIN_EXPORT void nodeimg_register_nodes(NodeRegistry& registry)
@@ -0,0 +1,25 @@
+// include/ParamArchive.hpp
+#pragma once
+#include <string>
+#include <vector>
+
+/**
+ * Two-way visitor over a node's saved parameters.
+ *
+ * A node lists its parameters once in BaseNode::serializeParams(); the same
+ * code then saves (values are read) or loads (values are assigned) depending
+ * on the archive. When loading, a key missing from the file leaves the
+ * current value untouched, so older files stay loadable.
+ */
+class ParamArchive {
+public:
+    virtual ~ParamArchive() = default;
+
+    virtual bool loading() const = 0;
+
+    virtual void field(const char* key, int& value) = 0;
+    virtual void field(const char* key, float& value) = 0;
+    virtual void field(const char* key, bool& value) = 0;
+    virtual void field(const char* key, std::string& value) = 0;
+    virtual void field(const char* key, std::vector<float>& value) = 0;
+};
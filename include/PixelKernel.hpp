@@ -0,0 +1,75 @@
+// include/PixelKernel.hpp
+#pragma once
+#include <opencv2/core.hpp>
+#include <utility>
+
+/**
+ * Compile-time pixel formats for node kernels.
+ *
+ * A kernel written as a template over its channel type (and, where it
+ * matters, its channel count) is instantiated once per format the engine
+ * works in, and the image's runtime type picks the instantiation:
+ *
+ *     dispatchPixelFormat(image.type(), [&](auto format) {
+ *         using Format = decltype(format);
+ *         invertRows<typename Format::Channel, Format::channels>(image, result);
+ *     });
+ *
+ * Each instantiation sees its channel type and count as constants, so inner
+ * loops need no per-pixel branches and can be vectorized. The formats are
+ * those of the working precisions (8-bit, 16-bit, float) with one, three or
+ * four channels; anything else is left to the caller.
+ */
+template <typename T, int Channels>
+struct PixelFormat {
+    using Channel = T;
+    static constexpr int channels = Channels;
+    static constexpr int depth = cv::DataType<T>::depth;
+};
+
+// Calls kernel(PixelFormat<T, 1>{}) for the channel type of an 8U, 16U or
+// 32F depth; false for other depths
+template <typename Kernel>
+bool dispatchDepth(int depth, Kernel&& kernel) {
+    switch (depth) {
+        case CV_8U:  kernel(PixelFormat<unsigned char, 1>{}); return true;
+        case CV_16U: kernel(PixelFormat<unsigned short, 1>{}); return true;
+        case CV_32F: kernel(PixelFormat<float, 1>{}); return true;
+        default:     return false;
+    }
+}
+
+namespace pixel_kernel_detail {
+
+template <typename T, typename Kernel>
+bool dispatchChannels(int channels, Kernel&& kernel) {
+    switch (channels) {
+        case 1:  kernel(PixelFormat<T, 1>{}); return true;
+        case 3:  kernel(PixelFormat<T, 3>{}); return true;
+        case 4:  kernel(PixelFormat<T, 4>{}); return true;
+        default: return false;
+    }
+}
+
+} // namespace pixel_kernel_detail
+
+// Calls kernel(PixelFormat<T, N>{}) for a cv::Mat type of 8U, 16U or 32F
+// with 1, 3 or 4 channels; false for other types
+template <typename Kernel>
+bool dispatchPixelFormat(int type, Kernel&& kernel) {
+    const int channels = CV_MAT_CN(type);
+    switch (CV_MAT_DEPTH(type)) {
+        case CV_8U:  return pixel_kernel_detail::dispatchChannels<unsigned char>(channels, std::forward<Kernel>(kernel));
+        case CV_16U: return pixel_kernel_detail::dispatchChannels<unsigned short>(channels, std::forward<Kernel>(kernel));
+        case CV_32F: return pixel_kernel_detail::dispatchChannels<float>(channels, std::forward<Kernel>(kernel));
+        default:     return false;
+    }
+}
+
+// Runs rowKernel(y) for every row of an image, split over OpenCV's workers
+template <typename RowKernel>
+void forEachRow(int rows, RowKernel&& rowKernel) {
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) rowKernel(y);
+    });
+}
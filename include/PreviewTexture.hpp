@@ -0,0 +1,30 @@
+// include/PreviewTexture.hpp
+#pragma once
+#include <opencv2/core.hpp>
+#include <imgui.h>
+#include <functional>
+#include <memory>
+
+/**
+ * GPU texture used to display node previews in the editor.
+ *
+ * The node library has no GL dependency: the GUI registers a factory for its
+ * GL implementation at startup. Headless builds never register one, so
+ * available() is false and nodes skip preparing previews altogether.
+ */
+class PreviewTexture {
+public:
+    using Factory = std::function<std::unique_ptr<PreviewTexture>()>;
+
+    virtual ~PreviewTexture() = default;
+
+    // Uploads a gray, BGR or BGRA image, top row first, with 8-bit, 16-bit
+    // or half-float (CV_16F) channels; must be called on the thread owning
+    // the context
+    virtual void upload(const cv::Mat& image) = 0;
+    virtual ImTextureID id() const = 0;
+
+    static void setFactory(Factory factory);
+    static bool available();
+    static std::unique_ptr<PreviewTexture> create();
+};
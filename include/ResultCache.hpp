@@ -0,0 +1,68 @@
+// include/ResultCache.hpp
+#pragma once
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Memoized node outputs, keyed by node id and a hash of everything the
+ * outputs depend on: the node's parameters and the versions of its inputs.
+ *
+ * Every output pin carries a version, which is the key it was computed
+ * under (or, for nodes that are not memoized, one derived from their
+ * source, see BaseNode::outputVersion, or else a fresh value). Returning to
+ * an earlier parameter setting therefore reproduces the earlier keys all
+ * the way downstream, and each node finds its previous results here
+ * instead of recomputing them.
+ *
+ * Total pixel memory is bounded by a budget shared by all nodes; the least
+ * recently used results are evicted first. Cached images are shared with
+ * the graph's pins and are read-only like them.
+ */
+class ResultCache {
+public:
+    static uint64_t combine(uint64_t seed, uint64_t value);
+
+    // Output version for nodes whose results are not derived from a key
+    static uint64_t freshVersion();
+
+    bool lookup(int nodeId, uint64_t key, std::vector<cv::Mat>& outputs);
+    void store(int nodeId, uint64_t key, const std::vector<cv::Mat>& outputs);
+
+    void forget(int nodeId);
+    void clear();
+
+    void setBudget(size_t bytes); // 0 disables memoization
+    size_t budget() const;
+    size_t usage() const;
+
+    struct Counters {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+    Counters counters() const;
+
+private:
+    struct Entry {
+        int nodeId;
+        uint64_t key;
+        std::vector<cv::Mat> outputs;
+        size_t bytes = 0;
+    };
+
+    static uint64_t slot(int nodeId, uint64_t key);
+    void evictLocked();
+
+    std::list<Entry> lru; // Front is the most recently used entry
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+    size_t budgetBytes = size_t(512) * 1024 * 1024; // 512 MB by default
+    size_t usedBytes = 0;
+    Counters stats;
+    mutable std::mutex mutex;
+    static std::atomic<uint64_t> versionCounter;
+};
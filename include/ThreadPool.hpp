@@ -0,0 +1,51 @@
+// include/ThreadPool.hpp
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed-size work-stealing thread pool.
+ *
+ * Every worker owns a task deque. Tasks submitted from a worker go to the
+ * back of its own deque and are popped LIFO, which keeps a chain of dependent
+ * nodes on one core. Idle workers steal from the front of other workers'
+ * deques. Tasks submitted from outside the pool are spread round-robin.
+ */
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    // workerCount == 0 uses std::thread::hardware_concurrency()
+    explicit ThreadPool(unsigned workerCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(Task task);
+    unsigned workerCount() const { return static_cast<unsigned>(queues.size()); }
+
+private:
+    struct WorkQueue {
+        std::deque<Task> tasks;
+        std::mutex mutex;
+    };
+
+    void workerLoop(unsigned index);
+    bool tryPop(unsigned index, Task& task);
+    bool trySteal(unsigned thief, Task& task);
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> queued{0};
+    std::atomic<unsigned> nextQueue{0};
+    std::atomic<bool> stopping{false};
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+};
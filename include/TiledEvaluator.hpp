@@ -0,0 +1,35 @@
+// include/TiledEvaluator.hpp
+#pragma once
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <vector>
+
+class NodeEditor;
+
+/**
+ * Evaluates a graph tile by tile so that intermediate buffers scale with the
+ * tile size instead of the image size.
+ *
+ * Nodes that declare a halo (BaseNode::tileHalo() >= 0) are run on tiles:
+ * for every output tile the required input region of each node is derived
+ * from its consumers' regions grown by their halos, and only that region is
+ * computed. Tiles are independent and spread over the editor's thread pool,
+ * each working on its own clones of the tiled nodes.
+ *
+ * Everything else (sources, global operations, sinks) runs on whole images
+ * as usual. The outputs of tiled nodes are assembled into full images only
+ * where an untiled node consumes them, or where nothing consumes them.
+ *
+ * Frozen nodes are handled as in NodeEditor's untiled passes: with valid
+ * files they are restored from the DiskCache and cut off their upstream,
+ * otherwise they run on whole images and store their results.
+ */
+class TiledEvaluator {
+public:
+    static void run(NodeEditor& editor, int tileSize);
+
+private:
+    // Region of the image a node has to produce for the current tile
+    static cv::Rect grow(const cv::Rect& region, int halo, const cv::Size& bounds);
+    static cv::Rect merge(const cv::Rect& a, const cv::Rect& b);
+};
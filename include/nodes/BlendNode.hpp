@@ -7,11 +7,21 @@ public:
     BlendNode();
     void process() override;
     void drawUI() override;
+    BaseNode* clone() const override;
+    void serializeParams(ParamArchive& ar) override;
+    int tileHalo() const override { return 0; }
+    bool supportsGpu() const override { return true; }
+    void processGpu() override;
     int getPinType(int pinId) const override;
 
 private:
     // Add this declaration
     cv::Mat blendImages(const cv::Mat& base, const cv::Mat& blend);
+    cv::UMat blendImagesGpu(const cv::UMat& base, const cv::UMat& blend);
+    template <typename Image>
+    static Image matchChannels(const Image& image, int channels);
+    template <typename Image>
+    static void prepareInputs(const Image& baseIn, const Image& blendIn, Image& base, Image& blend);
     
     int blendMode;
     float opacity;
@@ -1,6 +1,7 @@
 // BlurNode.hpp
 #pragma once
 #include "BaseNode.hpp"
+#include "FilterKernel.hpp"
 
 class BlurNode : public BaseNode {
 public:
@@ -8,9 +9,24 @@ public:
     BlurNode();
     void process() override;
     void drawUI() override;
+    BaseNode* clone() const override;
+    void serializeParams(ParamArchive& ar) override;
+    void adoptResults(const BaseNode& evaluated) override;
+    int tileHalo() const override { return radius; } // Both modes use a (2*radius+1)^2 kernel
+    bool supportsGpu() const override { return true; }
+    void processGpu() override;
     
 private:
+    template <typename Image>
+    void blur(const Image& input, Image& output);
+    // Builds the rotated kernel of the directional mode unless it is current
+    void prepareDirectionalKernel(int r);
+
     int radius = 3;
     bool directional = false;
     float angle = 0.0f;
+
+    FilterKernel directionalKernel; // For kernelRadius and kernelAngle
+    int kernelRadius = -1;
+    float kernelAngle = 0.0f;
 };
@@ -8,6 +8,11 @@ public:
     BrightnessContrastNode();
     void process() override;
     void drawUI() override;
+    BaseNode* clone() const override;
+    void serializeParams(ParamArchive& ar) override;
+    int tileHalo() const override { return 0; }
+    bool isPointwise() const override { return true; }
+    bool pointwiseLut(int channels, cv::Mat& lut, bool& toGray) const override;
     
 private:
     float brightness = 0.0f;
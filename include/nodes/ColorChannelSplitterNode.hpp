@@ -8,6 +8,13 @@ public:
     ColorChannelSplitterNode();
     void process() override;
     void drawUI() override;
+    BaseNode* clone() const override;
+    void serializeParams(ParamArchive& ar) override;
+    int tileHalo() const override { return 0; }
+    // Colorized outputs stay single-channel and are expanded only where needed
+    int outputColorChannel(size_t output) const override {
+        return !grayscaleOutput && output < 3 ? static_cast<int>(output) : -1;
+    }
     
 private:
     bool grayscaleOutput = true;
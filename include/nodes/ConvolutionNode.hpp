@@ -1,5 +1,7 @@
 #pragma once
 #include "BaseNode.hpp"
+#include "FilterKernel.hpp"
+#include <cstdint>
 #include <vector>
 
 class ConvolutionNode : public BaseNode {
@@ -7,6 +9,12 @@ public:
     ConvolutionNode();
     void process() override;
     void drawUI() override;
+    BaseNode* clone() const override;
+    void serializeParams(ParamArchive& ar) override;
+    void adoptResults(const BaseNode& evaluated) override;
+    int tileHalo() const override { return kernelSize / 2; }
+    bool supportsGpu() const override { return true; }
+    void processGpu() override;
     int getPinType(int pinId) const override;
 
     enum FilterPreset {
@@ -19,7 +27,17 @@ public:
         PRESET_COUNT
     };
 
+    static constexpr int kMaxKernelSize = 127;
+    static constexpr int kMaxEditableSize = 15; // Larger kernels get no matrix editor
+
 private:
+    template <typename Image>
+    void convolve(const Image& source, Image& result, FilterKernel& filter);
+    // The filter for the current proxyScale, rebuilt from kernel and
+    // kernelScale when they were edited
+    FilterKernel& prepareFilter();
+    // kernel times kernelScale, resampled to the current proxyScale
+    cv::Mat scaledKernel() const;
     void updateKernelSize(int newSize);
     void loadPreset(FilterPreset preset);
     void normalizeKernel();
@@ -28,4 +46,14 @@ private:
     std::vector<std::vector<float>> kernel;
     FilterPreset currentPreset;
     float kernelScale;
+
+    // One prepared filter per proxy scale, so switching between proxies and
+    // full results keeps each kernel's DFT spectrum. Their buffers are shared
+    // with clones and never written in place.
+    struct ScaledFilter {
+        double scale;
+        uint64_t key;          // paramHash() the filter was built for
+        FilterKernel filter;
+    };
+    std::vector<ScaledFilter> filters;
 };
@@ -7,9 +7,17 @@ public:
     EdgeDetectionNode();
     void process() override;
     void drawUI() override;
+    BaseNode* clone() const override;
+    void serializeParams(ParamArchive& ar) override;
+    int tileHalo() const override;
+    bool supportsGpu() const override { return true; }
+    void processGpu() override;
     int getPinType(int pinId) const override;
 
 private:
+    template <typename Image>
+    void detectEdges(const Image& inputImage, const Image& grayImage, Image& result) const;
+
     int method = 0;          // 0: Sobel, 1: Canny, 2: Laplacian
     float threshold1 = 50.0f;
     float threshold2 = 150.0f;
@@ -1,6 +1,9 @@
 // ImageInputNode.hpp
 #pragma once
 #include "BaseNode.hpp"
+#include "FramePrefetcher.hpp"
+#include "ImageCache.hpp"
+#include <memory>
 
 class ImageInputNode : public BaseNode {
 public:
@@ -8,8 +11,43 @@ public:
     ImageInputNode();
     void process() override;
     void drawUI() override;
+    BaseNode* clone() const override;
+    void serializeParams(ParamArchive& ar) override;
+    void adoptResults(const BaseNode& evaluated) override;
+    bool memoizable() const override { return false; } // Output follows the file, not the parameters
+    uint64_t outputVersion(size_t output) const override;
+    cv::Size sourceSize() const override { return originalImage.size(); }
+    double redrawIn(double now) const override;
+    void setImage(const cv::Mat& image);
     
 private:
+    // originalImage at workingDepth, converted once per image
+    const cv::Mat& workingImage();
+    // source (the working image) downscaled to proxyScale, rebuilt only when either changes
+    const cv::Mat& proxyImage(const cv::Mat& source);
+    void drawTimeline();
+
+    enum Mode { MODE_IMAGE = 0, MODE_SEQUENCE };
+
+    int mode = MODE_IMAGE;
     std::string filepath;
-    cv::Mat originalImage;
+    cv::Mat originalImage;          // Shared with ImageCache, read-only
+    ImageCache::Stamp loadedStamp;  // File state originalImage was decoded from
+    static constexpr double kStampPollInterval = 1.0; // Seconds between checks for edits on disk
+    double nextStampCheck = 0.0;    // ImGui time of the next check
+    cv::Mat working;                // originalImage converted to workingDepth, read-only
+    cv::Mat workingSource;          // The image working was converted from
+    cv::Mat proxy;                  // Shared downstream, read-only
+    cv::Mat proxySource;            // The image proxy was made from
+    double proxyBuiltScale = 1.0;
+
+    // Sequence mode: a video file or numbered image pattern, played back
+    // through a prefetcher shared with evaluation clones
+    std::string sequencePath;
+    int frame = 0;
+    float playbackFps = 0.0f;  // 0 = the source's own rate
+    std::shared_ptr<FramePrefetcher> sequence; // Opened by process(), kept by adoptResults()
+    int loadedFrame = -1;      // Frame originalImage holds, once its evaluation is adopted
+    bool playing = false;
+    double lastAdvance = 0.0;  // ImGui time of the last frame step
 };
@@ -1,13 +1,15 @@
 // NoiseNode.hpp
 #pragma once
 #include "BaseNode.hpp"
-#include <random>
 
 class NoiseNode : public BaseNode {
 public:
     NoiseNode();
     void process() override;
     void drawUI() override;
+    BaseNode* clone() const override;
+    void serializeParams(ParamArchive& ar) override;
+    cv::Size sourceSize() const override { return cv::Size(width, height); }
     int getPinType(int pinId) const override;
 
 private:
@@ -18,20 +20,18 @@ private:
     int outputMode = 0; // 0: Direct color, 1: Displacement map
     int width = 512;
     int height = 512;
+    int seed = 0;           // Worley feature points are a pure function of the seed
+    int worleyDistance = 0; // 0: F1, 1: F2, 2: F2 - F1
     
-    // Noise generation methods
-    cv::Mat generatePerlinNoise(int width, int height);
-    cv::Mat generateSimplexNoise(int width, int height);
-    cv::Mat generateWorleyNoise(int width, int height);
+    // Noise generation methods; each returns a single-channel CV_32F map in 0..1.
+    // Other channels sample the same field far away from channel 0, which
+    // gives an uncorrelated map with the same character.
+    cv::Mat generateNoise(int width, int height, int channel);
+    cv::Mat generatePerlinNoise(int width, int height, int channel = 0);
+    cv::Mat generateSimplexNoise(int width, int height, int channel = 0);
+    cv::Mat generateWorleyNoise(int width, int height, int channel = 0);
     
-    // Helper methods for noise generation
-    float perlinNoise(float x, float y, int octaves, float persistence);
-    float simplexNoise(float x, float y);
-    float worleyNoise(float x, float y);
-    
-    // Displacement map application
-    cv::Mat applyDisplacementMap(const cv::Mat& inputImage, const cv::Mat& noiseMap);
-    
-    // Random number generation
-    std::mt19937 rng;
+    // Displacement map application: noiseX and noiseY shift pixels horizontally and vertically
+    static cv::Mat applyDisplacementMap(const cv::Mat& inputImage, const cv::Mat& noiseX,
+                                        const cv::Mat& noiseY, float amplitude);
 };
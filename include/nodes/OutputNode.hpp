@@ -1,21 +1,51 @@
 #pragma once
 #include "BaseNode.hpp"
+#include "PreviewTexture.hpp"
+#include <future>
+#include <memory>
 #include <string>
-#include <GL/glew.h>
+#include <vector>
 
 class OutputNode : public BaseNode {
 public:
     OutputNode();
+    OutputNode(const OutputNode& other); // Copies settings and results, never the texture
+    OutputNode& operator=(const OutputNode&) = delete;
     ~OutputNode() override;
     void process() override;
     void drawUI() override;
+    BaseNode* clone() const override;
+    void serializeParams(ParamArchive& ar) override;
+    void adoptResults(const BaseNode& evaluated) override;
+    bool memoizable() const override { return false; } // Prepares the preview as a side effect
+    bool readsChannelViews() const override { return true; } // Expands lone channels itself, once
     int getPinType(int pinId) const override;
-    void saveImage(const std::string& path);
+    // Queues the result on ImageEncoder::shared(); false if there is nothing to save yet
+    bool saveImage(const std::string& path);
+
+    // Final image reaching this node and how it should be encoded. Gray
+    // stays gray; a lone color channel is saved as the color image it stands for.
+    cv::Mat result() const { return inputs[0].colorChannel >= 0 ? inputs[0].color() : inputs[0].data; }
+    std::string fileExtension() const;
+    std::vector<int> encodeParams() const;
 
 private:
-    GLuint textureID = 0;
+    // process() runs on a worker thread, so it only prepares the preview;
+    // the upload happens in drawUI() on the thread owning the GL context
+    void uploadPreview();
+    void drawSaveStatus();
+
     std::string filepath;
-    int format = 0;       // 0: PNG, 1: JPEG, 2: BMP
+    int format = 0;       // 0: PNG, 1: JPEG, 2: BMP, 3: TIFF, 4: OpenEXR
     int quality = 95;
     int compression = 3;  // Compression level for PNG
+    bool halfFloat = true; // OpenEXR channel type
+
+    std::future<bool> pendingSave; // Never copied to clones
+    std::string saveStatus;
+
+    std::unique_ptr<PreviewTexture> texture; // Created lazily; stays null when headless
+    cv::Mat preview;           // 8-bit gray, BGR or BGRA; may share the input buffer
+    uint64_t previewVersion = 0; // Input version the preview was made from
+    bool previewPending = false;
 };
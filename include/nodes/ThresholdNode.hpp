@@ -8,12 +8,17 @@ public:
     ThresholdNode();
     void process() override;
     void drawUI() override;
+    BaseNode* clone() const override;
+    void serializeParams(ParamArchive& ar) override;
+    int tileHalo() const override;
+    bool isPointwise() const override { return method == 0; }
+    bool pointwiseLut(int channels, cv::Mat& lut, bool& toGray) const override;
+    bool readsInputStats() const override { return method == 2; }
+    bool showsInput() const override { return true; } // Histogram
     int getPinType(int pinId) const override;
 
 private:
-    // Add these declarations
-    void calculateHistogram();  // Method declaration
-    std::vector<float> histogram;  // Member variable
+    void drawHistogram();
     
     int method = 0;
     float thresholdValue = 128.0f;
@@ -1,3 +1,152 @@
 #include "BaseNode.hpp"
+#include <cstring>
 
-int BaseNode::nextId = 0; // Define and initialize the static member
\ No newline at end of file
+namespace {
+
+// Feeds every saved parameter into a 64-bit FNV-1a hash
+class HashArchive : public ParamArchive {
+public:
+    bool loading() const override { return false; }
+    void field(const char* key, int& value) override { mix(key, &value, sizeof(value)); }
+    void field(const char* key, float& value) override { mix(key, &value, sizeof(value)); }
+    void field(const char* key, bool& value) override {
+        char b = value ? 1 : 0;
+        mix(key, &b, 1);
+    }
+    void field(const char* key, std::string& value) override { mix(key, value.data(), value.size()); }
+    void field(const char* key, std::vector<float>& value) override {
+        mix(key, value.data(), value.size() * sizeof(float));
+    }
+
+    void bytes(const void* data, size_t size) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ p[i]) * 0x100000001b3ull;
+        }
+    }
+
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+private:
+    void mix(const char* key, const void* data, size_t size) {
+        bytes(key, std::strlen(key) + 1);
+        uint64_t length = size;
+        bytes(&length, sizeof(length));
+        bytes(data, size);
+    }
+};
+
+// Views made from an earlier buffer are dropped before anything is reused.
+// Consumers that had a lone channel expanded hold the color view itself,
+// which belongs to the same views. Called with views.mutex held.
+void syncViews(PinViews& views, const cv::Mat& data) {
+    const bool colorView = !views.color.empty() && views.color.data == data.data &&
+                           views.color.size() == data.size();
+    if (!colorView && (views.source.data != data.data || views.source.size() != data.size())) {
+        views.source = data;
+        views.gray = cv::Mat();
+        views.color = cv::Mat();
+        views.stats.reset();
+    }
+}
+
+} // namespace
+
+int BaseNode::nextId = 0; // Define and initialize the static member
+
+cv::Mat Pin::expandChannel(const cv::Mat& data, int channel) {
+    cv::Mat color(data.size(), CV_MAKETYPE(data.depth(), 3), cv::Scalar::all(0));
+    cv::mixChannels({data}, {color}, {0, channel});
+    return color;
+}
+
+cv::Mat Pin::color() const {
+    if (data.empty() || data.channels() != 1) return data;
+
+    auto convert = [this] {
+        if (colorChannel >= 0) return expandChannel(data, colorChannel);
+        cv::Mat color;
+        cv::cvtColor(data, color, cv::COLOR_GRAY2BGR);
+        return color;
+    };
+    if (!views) return convert();
+
+    // Consumers running in parallel wait for the first one's conversion
+    std::lock_guard<std::mutex> lock(views->mutex);
+    syncViews(*views, data);
+    if (views->color.empty()) views->color = convert();
+    return views->color;
+}
+
+cv::Mat Pin::gray() const {
+    if (data.empty() || (data.channels() == 1 && colorChannel < 0)) return data;
+
+    // Gray of a lone channel goes through its color image, so it weighs the
+    // channel like any other BGR-to-gray conversion
+    cv::Mat colored = colorChannel >= 0 && data.channels() == 1 ? color() : data;
+    auto convert = [&colored] {
+        cv::Mat gray;
+        cv::cvtColor(colored, gray, colored.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+        return gray;
+    };
+    if (colored.channels() != 3 && colored.channels() != 4) return colored;
+    if (!views) return convert();
+
+    std::lock_guard<std::mutex> lock(views->mutex);
+    syncViews(*views, data);
+    if (views->gray.empty()) views->gray = convert();
+    return views->gray;
+}
+
+std::shared_ptr<const ImageStats> Pin::stats() const {
+    if (data.empty()) return nullptr;
+    const cv::Mat source = gray(); // Takes the views lock itself
+    if (!views) return std::make_shared<const ImageStats>(ImageStats::of(source));
+
+    std::lock_guard<std::mutex> lock(views->mutex);
+    syncViews(*views, data);
+    if (!views->stats) views->stats = std::make_shared<const ImageStats>(ImageStats::of(source));
+    return views->stats;
+}
+
+void BaseNode::adoptResults(const BaseNode& evaluated) {
+    for (size_t i = 0; i < inputs.size() && i < evaluated.inputs.size(); ++i) {
+        inputs[i].data = evaluated.inputs[i].data;
+        inputs[i].gpu = evaluated.inputs[i].gpu;
+        inputs[i].version = evaluated.inputs[i].version;
+        inputs[i].colorChannel = evaluated.inputs[i].colorChannel;
+        inputs[i].views = evaluated.inputs[i].views;
+    }
+    for (size_t i = 0; i < outputs.size() && i < evaluated.outputs.size(); ++i) {
+        outputs[i].data = evaluated.outputs[i].data;
+        outputs[i].gpu = evaluated.outputs[i].gpu;
+        outputs[i].version = evaluated.outputs[i].version;
+        outputs[i].elided = evaluated.outputs[i].elided;
+        outputs[i].colorChannel = evaluated.outputs[i].colorChannel;
+        outputs[i].views = evaluated.outputs[i].views;
+    }
+}
+
+uint64_t BaseNode::paramHash() {
+    HashArchive ar;
+    ar.bytes(name.data(), name.size() + 1);
+    ar.bytes(&proxyScale, sizeof(proxyScale)); // Proxy results never stand in for full ones
+    ar.bytes(&workingDepth, sizeof(workingDepth));
+    serializeParams(ar);
+    return ar.hash;
+}
+
+double BaseNode::depthMax(int depth) {
+    switch (depth) {
+        case CV_8U:  return 255.0;
+        case CV_16U: return 65535.0;
+        default:     return 1.0;
+    }
+}
+
+cv::Mat BaseNode::convertDepth(const cv::Mat& image, int depth) {
+    if (image.empty() || image.depth() == depth) return image;
+    cv::Mat converted;
+    image.convertTo(converted, depth, depthMax(depth) / depthMax(image.depth()));
+    return converted;
+}
\ No newline at end of file
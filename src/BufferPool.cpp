@@ -0,0 +1,140 @@
+// BufferPool.cpp
+// Recycling cv::Mat allocator with working-set tracking
+#include "BufferPool.hpp"
+
+BufferPool& BufferPool::instance() {
+    // Never destroyed: cv::Mat objects with static lifetime may outlive any
+    // destructor order we could pick
+    static BufferPool* pool = new BufferPool();
+    return *pool;
+}
+
+void BufferPool::install() {
+    cv::Mat::setDefaultAllocator(&instance());
+}
+
+// Same layout rules as OpenCV's standard allocator; only the memory source differs
+cv::UMatData* BufferPool::allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                                   cv::AccessFlag /*flags*/, cv::UMatUsageFlags /*usageFlags*/) const {
+    size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; i--) {
+        if (step) {
+            if (data && step[i] != CV_AUTOSTEP) {
+                total = step[i];
+            } else {
+                step[i] = total;
+            }
+        }
+        total *= sizes[i];
+    }
+
+    unsigned char* buffer = data ? static_cast<unsigned char*>(data)
+                                 : static_cast<unsigned char*>(acquire(total));
+    cv::UMatData* u = new cv::UMatData(this);
+    u->data = u->origdata = buffer;
+    u->size = total;
+    if (data) u->flags |= cv::UMatData::USER_ALLOCATED;
+    return u;
+}
+
+bool BufferPool::allocate(cv::UMatData* data, cv::AccessFlag, cv::UMatUsageFlags) const {
+    return data != nullptr;
+}
+
+void BufferPool::deallocate(cv::UMatData* u) const {
+    if (!u) return;
+    CV_Assert(u->urefcount == 0);
+    CV_Assert(u->refcount == 0);
+    if (!(u->flags & cv::UMatData::USER_ALLOCATED)) {
+        release(u->origdata, u->size);
+        u->origdata = nullptr;
+    }
+    delete u;
+}
+
+void* BufferPool::acquire(size_t bytes) const {
+    const size_t now = inUseBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    size_t peak = peakBytes.load(std::memory_order_relaxed);
+    while (now > peak && !peakBytes.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {
+    }
+
+    if (bytes >= kMinPooledBytes) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = idle.find(bytes);
+        if (it != idle.end() && !it->second.empty()) {
+            void* buffer = it->second.back();
+            it->second.pop_back();
+            idleBytes -= bytes;
+            ++reusedCount;
+            return buffer;
+        }
+        ++allocatedCount;
+    }
+    return cv::fastMalloc(bytes);
+}
+
+void BufferPool::release(void* buffer, size_t bytes) const {
+    inUseBytes.fetch_sub(bytes, std::memory_order_relaxed);
+    if (bytes >= kMinPooledBytes) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (idleBytes + bytes <= budgetBytes) {
+            idle[bytes].push_back(buffer);
+            idleBytes += bytes;
+            return;
+        }
+    }
+    cv::fastFree(buffer);
+}
+
+BufferPool::Stats BufferPool::stats() const {
+    Stats s;
+    s.inUse = inUseBytes.load(std::memory_order_relaxed);
+    s.peak = peakBytes.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mutex);
+    s.idle = idleBytes;
+    s.reused = reusedCount;
+    s.allocated = allocatedCount;
+    return s;
+}
+
+void BufferPool::resetPeak() {
+    peakBytes.store(inUseBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void BufferPool::setIdleBudget(size_t bytes) {
+    std::vector<void*> freed;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        budgetBytes = bytes;
+        // Largest sizes go first; they are the least likely to fit a later request
+        while (idleBytes > budgetBytes && !idle.empty()) {
+            auto largest = idle.begin();
+            for (auto it = idle.begin(); it != idle.end(); ++it) {
+                if (it->first > largest->first) largest = it;
+            }
+            for (void* buffer : largest->second) {
+                freed.push_back(buffer);
+                idleBytes -= largest->first;
+            }
+            idle.erase(largest);
+        }
+    }
+    for (void* buffer : freed) cv::fastFree(buffer);
+}
+
+size_t BufferPool::idleBudget() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return budgetBytes;
+}
+
+void BufferPool::trim() {
+    std::unordered_map<size_t, std::vector<void*>> freed;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        freed.swap(idle);
+        idleBytes = 0;
+    }
+    for (const auto& entry : freed) {
+        for (void* buffer : entry.second) cv::fastFree(buffer);
+    }
+}
@@ -0,0 +1,290 @@
+// DiskCache.cpp
+// Raw, memory-mapped result files for frozen nodes
+#include "DiskCache.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char kMagic[4] = {'N', 'I', 'G', 'R'};
+
+// Pixels start on a page boundary so the mapped rows are aligned
+constexpr uint64_t kDataOffset = 4096;
+
+// Host byte order, like the binary graph format
+struct RawHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint64_t content;
+    int32_t rows;
+    int32_t cols;
+    int32_t type;
+    uint32_t reserved;
+    uint64_t dataOffset;
+    uint64_t dataBytes;
+};
+
+bool readHeaderFrom(std::istream& in, RawHeader& header) {
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    return std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+           header.version == DiskCache::kFormatVersion &&
+           header.rows >= 0 && header.cols >= 0 && header.dataOffset >= sizeof(RawHeader) &&
+           header.dataBytes == static_cast<uint64_t>(header.rows) * header.cols * CV_ELEM_SIZE(header.type);
+}
+
+#ifndef _WIN32
+// Owns the mapping behind a wrapped cv::Mat: OpenCV hands the buffer back
+// here once the last cv::Mat sharing it is released
+class MappingAllocator : public cv::MatAllocator {
+public:
+    // Only mapped buffers carry this allocator; anything else goes to the default one
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override {
+        return cv::Mat::getDefaultAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+    }
+    bool allocate(cv::UMatData* data, cv::AccessFlag, cv::UMatUsageFlags) const override {
+        return data != nullptr;
+    }
+    void deallocate(cv::UMatData* u) const override {
+        if (!u) return;
+        munmap(u->origdata, u->size);
+        delete u;
+    }
+
+    static MappingAllocator& instance() {
+        static MappingAllocator* allocator = new MappingAllocator(); // Outlives every cv::Mat
+        return *allocator;
+    }
+};
+#endif
+
+} // namespace
+
+DiskCache& DiskCache::instance() {
+    static DiskCache cache;
+    return cache;
+}
+
+bool DiskCache::writeRaw(const std::string& path, const cv::Mat& image, uint64_t key, uint64_t content) {
+    if (image.dims > 2) return false;
+
+    RawHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.key = key;
+    header.content = content;
+    header.rows = image.rows;
+    header.cols = image.cols;
+    header.type = image.type();
+    header.dataOffset = kDataOffset;
+    header.dataBytes = static_cast<uint64_t>(image.total()) * image.elemSize();
+
+    // Written aside and renamed, so a reader never maps a half-written file
+    // and results mapped from the previous file stay valid
+    const std::string temp = path + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        std::vector<char> head(kDataOffset, 0);
+        std::memcpy(head.data(), &header, sizeof(header));
+        out.write(head.data(), static_cast<std::streamsize>(head.size()));
+        const size_t rowBytes = image.cols * image.elemSize();
+        for (int y = 0; y < image.rows && out; ++y) {
+            out.write(reinterpret_cast<const char*>(image.ptr(y)), static_cast<std::streamsize>(rowBytes));
+        }
+        if (!out) {
+            std::cerr << "Cannot write disk cache file " << temp << std::endl;
+            out.close();
+            std::error_code ec;
+            fs::remove(temp, ec);
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(temp, path, ec);
+    if (ec) {
+        std::cerr << "Cannot write disk cache file " << path << ": " << ec.message() << std::endl;
+        fs::remove(temp, ec);
+        return false;
+    }
+    return true;
+}
+
+bool DiskCache::readHeader(const std::string& path, uint64_t& key, uint64_t& content) {
+    std::ifstream in(path, std::ios::binary);
+    RawHeader header;
+    if (!in || !readHeaderFrom(in, header)) return false;
+    key = header.key;
+    content = header.content;
+    return true;
+}
+
+cv::Mat DiskCache::mapRaw(const std::string& path, uint64_t& key, uint64_t& content) {
+    RawHeader header;
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in || !readHeaderFrom(in, header)) return cv::Mat();
+    }
+    key = header.key;
+    content = header.content;
+    if (header.dataBytes == 0) return cv::Mat();
+
+#ifdef _WIN32
+    // No mapping here; the pixels are read in one go instead
+    cv::Mat image(header.rows, header.cols, header.type);
+    std::ifstream in(path, std::ios::binary);
+    in.seekg(static_cast<std::streamoff>(header.dataOffset));
+    if (!in.read(reinterpret_cast<char*>(image.data), static_cast<std::streamsize>(header.dataBytes))) {
+        return cv::Mat();
+    }
+    return image;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return cv::Mat();
+    struct stat info;
+    const size_t length = static_cast<size_t>(header.dataOffset + header.dataBytes);
+    if (fstat(fd, &info) != 0 || static_cast<uint64_t>(info.st_size) < length) {
+        ::close(fd);
+        return cv::Mat();
+    }
+    // Private and writable: a stray write changes the process's copy of a
+    // page, never the file
+    void* base = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) return cv::Mat();
+
+    unsigned char* pixels = static_cast<unsigned char*>(base) + header.dataOffset;
+    cv::Mat image(header.rows, header.cols, header.type, pixels);
+    // Attach the mapping as the buffer's owner, as if the allocator had made it
+    cv::UMatData* u = new cv::UMatData(&MappingAllocator::instance());
+    u->origdata = static_cast<unsigned char*>(base);
+    u->data = pixels;
+    u->size = length;
+    u->refcount = 1;
+    image.u = u;
+    return image;
+#endif
+}
+
+std::string DiskCache::directoryFor(const std::string& graphPath) {
+    fs::path graph(graphPath);
+    return (graph.parent_path() / (graph.stem().string() + ".cache")).string();
+}
+
+void DiskCache::setDirectory(const std::string& directory) {
+    std::lock_guard<std::mutex> lock(mutex);
+    dir = directory;
+    checked.clear();
+}
+
+void DiskCache::remember(int nodeId, size_t outputCount, uint64_t key, bool valid) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    checked[nodeId] = {key, outputCount, valid};
+}
+
+void DiskCache::forget(int nodeId) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    checked.erase(nodeId);
+}
+
+std::string DiskCache::directory() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return dir;
+}
+
+void DiskCache::relocate(const std::string& target, const std::vector<int>& nodeIds) {
+    const std::string source = directory();
+    std::error_code ec;
+    if (!nodeIds.empty() && !fs::equivalent(source, target, ec)) {
+        fs::create_directories(target, ec);
+        for (int id : nodeIds) {
+            const std::string prefix = "node" + std::to_string(id) + "_";
+            for (const auto& entry : fs::directory_iterator(source, ec)) {
+                const std::string name = entry.path().filename().string();
+                if (name.compare(0, prefix.size(), prefix) != 0 || entry.path().extension() != ".nigr") continue;
+                fs::copy_file(entry.path(), fs::path(target) / name, fs::copy_options::overwrite_existing, ec);
+                if (ec) std::cerr << "Cannot copy " << entry.path() << ": " << ec.message() << std::endl;
+            }
+        }
+    }
+    setDirectory(target);
+}
+
+std::string DiskCache::pathFor(int nodeId, size_t output) const {
+    return (fs::path(directory()) / ("node" + std::to_string(nodeId) + "_" +
+                                     std::to_string(output) + ".nigr")).string();
+}
+
+bool DiskCache::has(int nodeId, size_t outputCount, uint64_t key) const {
+    if (outputCount == 0) return false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = checked.find(nodeId);
+        if (it != checked.end() && it->second.key == key && it->second.outputCount == outputCount) {
+            return it->second.valid;
+        }
+    }
+    bool valid = true;
+    for (size_t o = 0; o < outputCount && valid; ++o) {
+        uint64_t storedKey = 0, content = 0;
+        valid = readHeader(pathFor(nodeId, o), storedKey, content) && storedKey == key;
+    }
+    remember(nodeId, outputCount, key, valid);
+    return valid;
+}
+
+bool DiskCache::load(int nodeId, size_t outputCount, uint64_t key,
+                     std::vector<cv::Mat>& outputs, std::vector<uint64_t>& contents) const {
+    outputs.assign(outputCount, cv::Mat());
+    contents.assign(outputCount, 0);
+    for (size_t o = 0; o < outputCount; ++o) {
+        uint64_t storedKey = 0;
+        outputs[o] = mapRaw(pathFor(nodeId, o), storedKey, contents[o]);
+        if (storedKey != key || contents[o] == 0) {
+            forget(nodeId);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DiskCache::store(int nodeId, uint64_t key, const std::vector<cv::Mat>& outputs,
+                      std::vector<uint64_t>& contents) const {
+    std::error_code ec;
+    fs::create_directories(directory(), ec);
+
+    // Random ids: files outlive the session whose version counters made them
+    static std::mutex rngMutex;
+    static std::mt19937_64 rng(std::random_device{}());
+    contents.assign(outputs.size(), 0);
+    for (size_t o = 0; o < outputs.size(); ++o) {
+        {
+            std::lock_guard<std::mutex> lock(rngMutex);
+            while (contents[o] == 0) contents[o] = rng();
+        }
+        if (!writeRaw(pathFor(nodeId, o), outputs[o], key, contents[o])) {
+            forget(nodeId);
+            return false;
+        }
+    }
+    remember(nodeId, outputs.size(), key, !outputs.empty());
+    return true;
+}
+
+void DiskCache::remove(int nodeId, size_t outputCount) const {
+    std::error_code ec;
+    for (size_t o = 0; o < outputCount; ++o) fs::remove(pathFor(nodeId, o), ec);
+    forget(nodeId);
+}
@@ -0,0 +1,92 @@
+// FilterKernel.cpp
+// Separable, DFT and direct application of 2-D filter kernels
+#include "FilterKernel.hpp"
+#include <opencv2/imgproc.hpp>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// Energy beyond the first singular value, relative to the whole kernel,
+// below which the rank-one approximation is taken as exact. The error it
+// leaves is about a thousandth of the filter response, under half a level
+// in an 8-bit image.
+constexpr double kSeparableTolerance = 1e-6;
+
+} // namespace
+
+FilterKernel::FilterKernel(const cv::Mat& kernel) {
+    kernel.convertTo(dense, CV_32F);
+
+    cv::Mat w, u, vt;
+    cv::SVD::compute(dense, w, u, vt);
+    double total = 0.0;
+    for (int i = 0; i < w.rows; ++i) {
+        total += w.at<float>(i) * static_cast<double>(w.at<float>(i));
+    }
+    const double first = w.rows > 0 ? w.at<float>(0) : 0.0;
+    if (total > 0.0 && total - first * first <= kSeparableTolerance * total) {
+        // K = s * u0 * v0^T, split evenly between the two passes
+        const double root = std::sqrt(first);
+        columnKernel = u.col(0) * root;
+        rowKernel = vt.row(0) * root;
+    }
+}
+
+void FilterKernel::apply(const cv::Mat& input, cv::Mat& output, int borderType) {
+    if (separable()) {
+        cv::sepFilter2D(input, output, -1, rowKernel, columnKernel, cv::Point(-1, -1), 0, borderType);
+    } else if (size() >= kDftMinSize) {
+        applyDft(input, output, borderType);
+    } else {
+        cv::filter2D(input, output, -1, dense, cv::Point(-1, -1), 0, borderType);
+    }
+}
+
+void FilterKernel::apply(const cv::UMat& input, cv::UMat& output, int borderType) const {
+    if (separable()) {
+        cv::sepFilter2D(input, output, -1, rowKernel, columnKernel, cv::Point(-1, -1), 0, borderType);
+    } else {
+        cv::filter2D(input, output, -1, dense, cv::Point(-1, -1), 0, borderType);
+    }
+}
+
+// Correlation through the frequency domain: every channel is padded by the
+// kernel radius, multiplied with the conjugate kernel spectrum and cropped
+// back. The transform only has to cover the padded image, since the cropped
+// region never reads samples that wrapped around.
+void FilterKernel::applyDft(const cv::Mat& input, cv::Mat& output, int borderType) {
+    const int radius = size() / 2;
+    const cv::Size padded(input.cols + 2 * radius, input.rows + 2 * radius);
+    const cv::Size dftSize(cv::getOptimalDFTSize(padded.width), cv::getOptimalDFTSize(padded.height));
+
+    if (spectrum.empty() || spectrumSize != dftSize) {
+        // Built aside: the previous spectrum may be shared with a copy of this kernel
+        cv::Mat placed = cv::Mat::zeros(dftSize, CV_32F);
+        dense.copyTo(placed(cv::Rect(0, 0, dense.cols, dense.rows)));
+        cv::Mat transformed;
+        cv::dft(placed, transformed, 0, dense.rows);
+        spectrum = transformed;
+        spectrumSize = dftSize;
+    }
+
+    std::vector<cv::Mat> channels;
+    cv::split(input, channels);
+    for (cv::Mat& channel : channels) {
+        cv::Mat plane = cv::Mat::zeros(dftSize, CV_32F);
+        cv::Mat border;
+        cv::copyMakeBorder(channel, border, radius, radius, radius, radius, borderType);
+        cv::Mat target = plane(cv::Rect(cv::Point(0, 0), padded));
+        border.convertTo(target, CV_32F);
+
+        cv::Mat transformed, product, filtered;
+        cv::dft(plane, transformed, 0, padded.height);
+        cv::mulSpectrums(transformed, spectrum, product, 0, true);
+        cv::idft(product, filtered, cv::DFT_SCALE | cv::DFT_REAL_OUTPUT, input.rows);
+
+        cv::Mat result;
+        filtered(cv::Rect(0, 0, input.cols, input.rows)).convertTo(result, input.depth());
+        channel = result;
+    }
+    cv::merge(channels, output);
+}
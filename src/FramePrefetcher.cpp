@@ -0,0 +1,203 @@
+// FramePrefetcher.cpp
+// Read-ahead decoding of video files and numbered image sequences
+#include "FramePrefetcher.hpp"
+#include <opencv2/imgcodecs.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr int kSequenceWorkers = 2;
+
+std::function<void()> onAwaitedFrame;
+
+std::string formatFrame(const std::string& pattern, int number) {
+    std::vector<char> buffer(pattern.size() + 32);
+    std::snprintf(buffer.data(), buffer.size(), pattern.c_str(), number);
+    return buffer.data();
+}
+
+bool isImageExtension(std::string ext) {
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp" ||
+           ext == ".tif" || ext == ".tiff" || ext == ".exr";
+}
+
+} // namespace
+
+FramePrefetcher::~FramePrefetcher() {
+    stop();
+}
+
+std::string FramePrefetcher::patternFor(const std::string& path) {
+    fs::path file(path);
+    if (!isImageExtension(file.extension().string())) return path;
+
+    const std::string stem = file.stem().string();
+    size_t end = stem.size();
+    size_t begin = end;
+    while (begin > 0 && std::isdigit(static_cast<unsigned char>(stem[begin - 1]))) --begin;
+    if (begin == end) return path;
+
+    // A literal '%' in the name would be read as a conversion
+    std::string prefix;
+    for (char c : stem.substr(0, begin)) {
+        prefix += c;
+        if (c == '%') prefix += '%';
+    }
+    std::string name = prefix + "%0" + std::to_string(end - begin) + "d" + file.extension().string();
+    return (file.parent_path() / name).string();
+}
+
+bool FramePrefetcher::open(const std::string& source) {
+    stop();
+    frames.clear();
+    inFlight.clear();
+    windowStart = 0;
+    sourcePath = source;
+    pattern.clear();
+    count = 0;
+
+    int workerCount = 1;
+    if (source.find('%') != std::string::npos) {
+        // The sequence starts at the lowest of 0 and 1 that exists and ends
+        // before the first missing number
+        pattern = source;
+        firstNumber = fs::exists(formatFrame(pattern, 0)) ? 0 : 1;
+        while (fs::exists(formatFrame(pattern, firstNumber + count))) ++count;
+        rate = 24.0;
+        workerCount = kSequenceWorkers;
+    } else if (capture.open(source)) {
+        count = static_cast<int>(capture.get(cv::CAP_PROP_FRAME_COUNT));
+        double fps = capture.get(cv::CAP_PROP_FPS);
+        rate = fps > 0.0 ? fps : 24.0;
+        capturePosition = 0;
+    }
+    if (count <= 0) {
+        std::cerr << "Cannot open sequence or video: " << source << std::endl;
+        capture.release();
+        count = 0;
+        return false;
+    }
+
+    stopping = false;
+    for (int i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&FramePrefetcher::workerLoop, this);
+    }
+    return true;
+}
+
+void FramePrefetcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) worker.join();
+    workers.clear();
+    decoded.notify_all();
+}
+
+void FramePrefetcher::seek(int index) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        index = std::max(0, std::min(index, count - 1));
+        if (index == windowStart) return;
+        windowStart = index;
+        // Frames that left the window are dropped; readers still hold their own references
+        for (auto it = frames.begin(); it != frames.end();) {
+            if (it->first < windowStart - kBehind || it->first >= windowStart + kAhead) {
+                it = frames.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    wake.notify_all();
+}
+
+bool FramePrefetcher::ready(int index) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (frames.count(index) > 0) return true;
+    awaited = index;
+    return false;
+}
+
+void FramePrefetcher::setOnAwaitedFrame(std::function<void()> callback) {
+    onAwaitedFrame = std::move(callback);
+}
+
+cv::Mat FramePrefetcher::frame(int index) {
+    if (count <= 0) return cv::Mat();
+    index = std::max(0, std::min(index, count - 1));
+    seek(index);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    decoded.wait(lock, [&] { return stopping || frames.count(index) > 0; });
+    auto it = frames.find(index);
+    return it != frames.end() ? it->second : cv::Mat();
+}
+
+// Closest missing frame ahead of the window start
+int FramePrefetcher::nextToDecodeLocked() const {
+    const int end = std::min(windowStart + kAhead, count);
+    for (int i = windowStart; i < end; ++i) {
+        if (!frames.count(i) && !inFlight.count(i)) return i;
+    }
+    return -1;
+}
+
+void FramePrefetcher::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        int index = nextToDecodeLocked();
+        if (index < 0) {
+            wake.wait(lock);
+            continue;
+        }
+        inFlight.insert(index);
+        lock.unlock();
+
+        cv::Mat image = decode(index);
+
+        lock.lock();
+        inFlight.erase(index);
+        // Stored even when empty, so readers waiting on a broken frame return
+        if (index >= windowStart - kBehind && index < windowStart + kAhead) {
+            frames[index] = image;
+        }
+        decoded.notify_all();
+        if (index == awaited) {
+            awaited = -1;
+            if (onAwaitedFrame) {
+                lock.unlock();
+                onAwaitedFrame();
+                lock.lock();
+            }
+        }
+    }
+}
+
+cv::Mat FramePrefetcher::decode(int index) {
+    cv::Mat image;
+    try {
+        if (!pattern.empty()) {
+            image = cv::imread(formatFrame(pattern, firstNumber + index), cv::IMREAD_COLOR | cv::IMREAD_ANYDEPTH);
+        } else {
+            // Sequential reads are cheap; anything else needs a seek
+            if (index != capturePosition) capture.set(cv::CAP_PROP_POS_FRAMES, index);
+            if (!capture.read(image)) image = cv::Mat();
+            capturePosition = index + 1;
+        }
+    } catch (const cv::Exception& e) {
+        std::cerr << "Cannot decode frame " << index << " of " << sourcePath << ": " << e.what() << std::endl;
+        image = cv::Mat();
+    }
+    return image;
+}
@@ -0,0 +1,96 @@
+// GLPreviewTexture.cpp
+// OpenGL texture backing the OutputNode preview
+#include "GLPreviewTexture.hpp"
+#include <cstring>
+
+namespace {
+
+// Transfer type and sized internal format for a supported channel depth
+GLenum pixelType(int depth) {
+    return depth == CV_16U ? GL_UNSIGNED_SHORT : depth == CV_16F ? GL_HALF_FLOAT : GL_UNSIGNED_BYTE;
+}
+
+GLint internalFormatFor(int channels, int depth) {
+    if (depth == CV_16F) return channels == 1 ? GL_R16F : channels == 4 ? GL_RGBA16F : GL_RGB16F;
+    if (depth == CV_16U) return channels == 1 ? GL_R16 : channels == 4 ? GL_RGBA16 : GL_RGB16;
+    return channels == 1 ? GL_R8 : channels == 4 ? GL_RGBA8 : GL_RGB8;
+}
+
+} // namespace
+
+GLPreviewTexture::GLPreviewTexture() {
+    glGenTextures(1, &textureID);
+    glGenBuffers(static_cast<GLsizei>(pixelBuffers.size()), pixelBuffers.data());
+}
+
+GLPreviewTexture::~GLPreviewTexture() {
+    glDeleteBuffers(static_cast<GLsizei>(pixelBuffers.size()), pixelBuffers.data());
+    if (textureID != 0) {
+        glDeleteTextures(1, &textureID);
+    }
+}
+
+void GLPreviewTexture::allocate(int newWidth, int newHeight, int newChannels, int newDepth) {
+    const GLint internalFormat = internalFormatFor(newChannels, newDepth);
+    const GLenum format = newChannels == 1 ? GL_RED : newChannels == 4 ? GL_BGRA : GL_BGR;
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, newWidth, newHeight, 0,
+                 format, pixelType(newDepth), nullptr);
+
+    // Gray images are stored as one channel and shown as gray, not red
+    const GLint gray[] = {GL_RED, GL_RED, GL_RED, GL_ONE};
+    const GLint color[] = {GL_RED, GL_GREEN, GL_BLUE, newChannels == 4 ? GL_ALPHA : GL_ONE};
+    glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, newChannels == 1 ? gray : color);
+
+    width = newWidth;
+    height = newHeight;
+    channels = newChannels;
+    depth = newDepth;
+}
+
+void GLPreviewTexture::upload(const cv::Mat& image) {
+    const int imageDepth = image.depth();
+    if (image.empty() || (imageDepth != CV_8U && imageDepth != CV_16U && imageDepth != CV_16F)) return;
+    const int imageChannels = image.channels();
+    if (imageChannels != 1 && imageChannels != 3 && imageChannels != 4) return;
+
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    if (image.cols != width || image.rows != height || imageChannels != channels || imageDepth != depth) {
+        allocate(image.cols, image.rows, imageChannels, imageDepth);
+    }
+
+    // Orphan the next buffer so the driver never has to wait for its last transfer
+    const size_t rowBytes = static_cast<size_t>(image.cols) * image.elemSize();
+    const size_t bytes = rowBytes * image.rows;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[nextBuffer]);
+    nextBuffer = (nextBuffer + 1) % pixelBuffers.size();
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(bytes), nullptr, GL_STREAM_DRAW);
+
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(bytes),
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped) {
+        unsigned char* target = static_cast<unsigned char*>(mapped);
+        if (image.isContinuous()) {
+            std::memcpy(target, image.data, bytes);
+        } else {
+            for (int y = 0; y < image.rows; y++) {
+                std::memcpy(target + y * rowBytes, image.ptr(y), rowBytes);
+            }
+        }
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        // Rows are tightly packed; the transfer itself runs asynchronously
+        const GLenum format = imageChannels == 1 ? GL_RED : imageChannels == 4 ? GL_BGRA : GL_BGR;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.cols, image.rows,
+                        format, pixelType(imageDepth), nullptr);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+ImTextureID GLPreviewTexture::id() const {
+    return (ImTextureID)(intptr_t)textureID;
+}
@@ -0,0 +1,572 @@
+// GraphSerializer.cpp
+// Binary and JSON save/load of the node graph shared by the editor and the batch runner
+#include <imnodes.h>
+#include "GraphSerializer.hpp"
+#include "DiskCache.hpp"
+#include "NodeEditor.hpp"
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+namespace {
+
+bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() &&
+           text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// ---------------------------------------------------------------------------
+// Binary format. All values are written in host byte order (little-endian on
+// every platform we build for).
+//
+//   header      magic "NIGF", u32 version, u32 flags, i32 nextId,
+//               u32 nodeCount, u32 connectionCount,
+//               u8 depthBits (8, 16 or 32; version 2 and later)
+//   node        str type, i32 id, u16 inputCount, i32 inputIds[],
+//               u16 outputCount, i32 outputIds[], [f32 x, f32 y],
+//               u32 paramBytes, params
+//   param       u8 tag, str key, value (i32 / f32 / u8 / str / u32 n + f32[n])
+//   connection  i32 outputPin, i32 inputPin
+//   order       u32 count, u32 nodeIndices[]   (version 2 and earlier only;
+//               skipped on load, the graph is re-sorted instead)
+//
+// str is a u16 length followed by the bytes.
+// ---------------------------------------------------------------------------
+const char kMagic[4] = {'N', 'I', 'G', 'F'};
+const uint32_t kFlagLayout = 1u << 0;
+
+enum ParamTag : uint8_t { TagInt = 1, TagFloat, TagBool, TagString, TagFloats };
+
+class BinaryWriter {
+public:
+    template <typename T>
+    void put(T value) {
+        const char* bytes = reinterpret_cast<const char*>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    void putString(const std::string& text) {
+        size_t length = std::min<size_t>(text.size(), UINT16_MAX);
+        put(static_cast<uint16_t>(length));
+        buffer.insert(buffer.end(), text.begin(), text.begin() + length);
+    }
+
+    // Reserves a u32 size field; endBlock() fills it with the bytes written since
+    size_t beginBlock() {
+        put<uint32_t>(0);
+        return buffer.size();
+    }
+
+    void endBlock(size_t start) {
+        uint32_t size = static_cast<uint32_t>(buffer.size() - start);
+        std::memcpy(&buffer[start - sizeof(uint32_t)], &size, sizeof(size));
+    }
+
+    std::vector<char> buffer;
+};
+
+// Bounds-checked cursor; any overrun latches the failure flag
+class BinaryReader {
+public:
+    BinaryReader(const char* data, size_t size) : cursor(data), end(data + size) {}
+
+    template <typename T>
+    T get() {
+        T value{};
+        if (const char* p = take(sizeof(T))) std::memcpy(&value, p, sizeof(T));
+        return value;
+    }
+
+    std::string getString() {
+        uint16_t length = get<uint16_t>();
+        const char* p = take(length);
+        return p ? std::string(p, length) : std::string();
+    }
+
+    // Returns the start of the next `bytes` bytes and skips past them
+    const char* take(size_t bytes) {
+        if (failed || static_cast<size_t>(end - cursor) < bytes) {
+            failed = true;
+            return nullptr;
+        }
+        cursor += bytes;
+        return cursor - bytes;
+    }
+
+    bool ok() const { return !failed; }
+
+private:
+    const char* cursor;
+    const char* end;
+    bool failed = false;
+};
+
+class BinaryParamWriter : public ParamArchive {
+public:
+    explicit BinaryParamWriter(BinaryWriter& out) : out(out) {}
+    bool loading() const override { return false; }
+
+    void field(const char* key, int& value) override { header(TagInt, key); out.put<int32_t>(value); }
+    void field(const char* key, float& value) override { header(TagFloat, key); out.put(value); }
+    void field(const char* key, bool& value) override { header(TagBool, key); out.put<uint8_t>(value); }
+    void field(const char* key, std::string& value) override { header(TagString, key); out.putString(value); }
+    void field(const char* key, std::vector<float>& value) override {
+        header(TagFloats, key);
+        out.put(static_cast<uint32_t>(value.size()));
+        for (float v : value) out.put(v);
+    }
+
+private:
+    void header(ParamTag tag, const char* key) {
+        out.put<uint8_t>(tag);
+        out.putString(key);
+    }
+
+    BinaryWriter& out;
+};
+
+// Indexes a node's parameter block once, then serves fields by key
+class BinaryParamReader : public ParamArchive {
+public:
+    BinaryParamReader(const char* data, size_t size) {
+        BinaryReader in(data, size);
+        while (in.ok() && in.take(0) != data + size) {
+            Entry entry;
+            entry.tag = in.get<uint8_t>();
+            entry.key = in.getString();
+            entry.value = in.take(0);
+            switch (entry.tag) {
+                case TagInt: in.take(sizeof(int32_t)); break;
+                case TagFloat: in.take(sizeof(float)); break;
+                case TagBool: in.take(sizeof(uint8_t)); break;
+                case TagString: in.take(in.get<uint16_t>()); break;
+                case TagFloats: in.take(static_cast<size_t>(in.get<uint32_t>()) * sizeof(float)); break;
+                default: return; // Unknown tag from a newer writer: ignore the rest
+            }
+            if (!in.ok()) break;
+            entries.push_back(std::move(entry));
+        }
+    }
+
+    bool loading() const override { return true; }
+
+    void field(const char* key, int& value) override {
+        if (const char* p = find(key, TagInt)) {
+            int32_t v;
+            std::memcpy(&v, p, sizeof(v));
+            value = v;
+        }
+    }
+    void field(const char* key, float& value) override {
+        if (const char* p = find(key, TagFloat)) std::memcpy(&value, p, sizeof(value));
+    }
+    void field(const char* key, bool& value) override {
+        if (const char* p = find(key, TagBool)) value = *p != 0;
+    }
+    void field(const char* key, std::string& value) override {
+        if (const char* p = find(key, TagString)) {
+            uint16_t length;
+            std::memcpy(&length, p, sizeof(length));
+            value.assign(p + sizeof(length), length);
+        }
+    }
+    void field(const char* key, std::vector<float>& value) override {
+        if (const char* p = find(key, TagFloats)) {
+            uint32_t count;
+            std::memcpy(&count, p, sizeof(count));
+            value.resize(count);
+            if (count) std::memcpy(value.data(), p + sizeof(count), count * sizeof(float));
+        }
+    }
+
+private:
+    struct Entry {
+        uint8_t tag;
+        std::string key;
+        const char* value;
+    };
+
+    const char* find(const char* key, uint8_t tag) const {
+        for (const auto& entry : entries) {
+            if (entry.tag == tag && entry.key == key) return entry.value;
+        }
+        return nullptr;
+    }
+
+    std::vector<Entry> entries;
+};
+
+// ---------------------------------------------------------------------------
+// JSON through cv::FileStorage
+// ---------------------------------------------------------------------------
+class JsonParamWriter : public ParamArchive {
+public:
+    explicit JsonParamWriter(cv::FileStorage& fs) : fs(fs) {}
+    bool loading() const override { return false; }
+
+    void field(const char* key, int& value) override { fs << key << value; }
+    void field(const char* key, float& value) override { fs << key << value; }
+    void field(const char* key, bool& value) override { fs << key << static_cast<int>(value); }
+    void field(const char* key, std::string& value) override { fs << key << value; }
+    void field(const char* key, std::vector<float>& value) override { fs << key << value; }
+
+private:
+    cv::FileStorage& fs;
+};
+
+class JsonParamReader : public ParamArchive {
+public:
+    explicit JsonParamReader(const cv::FileNode& node) : node(node) {}
+    bool loading() const override { return true; }
+
+    void field(const char* key, int& value) override { cv::read(node[key], value, value); }
+    void field(const char* key, float& value) override { cv::read(node[key], value, value); }
+    void field(const char* key, bool& value) override { cv::read(node[key], value, value); }
+    void field(const char* key, std::string& value) override { cv::read(node[key], value, value); }
+    void field(const char* key, std::vector<float>& value) override {
+        cv::FileNode entry = node[key];
+        if (!entry.empty()) entry >> value;
+    }
+
+private:
+    cv::FileNode node;
+};
+
+void writePinIds(cv::FileStorage& fs, const char* key, const std::vector<Pin>& pins) {
+    fs << key << "[";
+    for (const auto& pin : pins) {
+        fs << pin.id;
+    }
+    fs << "]";
+}
+
+bool readPinIds(const cv::FileNode& node, std::vector<Pin>& pins) {
+    if (node.size() != pins.size()) return false;
+    size_t i = 0;
+    for (const auto& id : node) {
+        pins[i++].id = static_cast<int>(id);
+    }
+    return true;
+}
+
+bool readPinIds(BinaryReader& in, std::vector<Pin>& pins) {
+    uint16_t count = in.get<uint16_t>();
+    if (!in.ok() || count != pins.size()) return false;
+    for (auto& pin : pins) {
+        pin.id = in.get<int32_t>();
+    }
+    return in.ok();
+}
+
+// The working depth is stored as bits per channel rather than as an OpenCV constant
+int depthBits(int depth) {
+    return depth == CV_16U ? 16 : depth == CV_32F ? 32 : 8;
+}
+
+int depthFromBits(int bits) {
+    return bits == 16 ? CV_16U : bits == 32 ? CV_32F : CV_8U;
+}
+
+} // namespace
+
+bool GraphSerializer::save(NodeEditor& editor, const std::string& path) {
+    // Frozen results move along to the directory that goes with the new file
+    std::vector<int> frozen;
+    for (const auto& node : editor.nodes) {
+        if (node->frozen) frozen.push_back(node->id);
+    }
+    DiskCache::instance().relocate(DiskCache::directoryFor(path), frozen);
+    return endsWith(path, ".json") ? exportJson(editor, path) : saveBinary(editor, path);
+}
+
+bool GraphSerializer::saveBinary(NodeEditor& editor, const std::string& path) {
+    const bool hasLayout = ImNodes::GetCurrentContext() != nullptr;
+    editor.pruneConnections();
+
+    BinaryWriter out;
+    out.buffer.reserve(64 + editor.nodes.size() * 96);
+    out.buffer.insert(out.buffer.end(), kMagic, kMagic + sizeof(kMagic));
+    out.put<uint32_t>(kBinaryVersion);
+    out.put<uint32_t>(hasLayout ? kFlagLayout : 0);
+    out.put<int32_t>(editor.currentId);
+    out.put<uint32_t>(static_cast<uint32_t>(editor.nodes.size()));
+    out.put<uint32_t>(static_cast<uint32_t>(editor.connections.size()));
+    out.put<uint8_t>(static_cast<uint8_t>(depthBits(editor.workingDepth)));
+
+    for (const auto& node : editor.nodes) {
+        out.putString(node->name);
+        out.put<int32_t>(node->id);
+        out.put<uint16_t>(static_cast<uint16_t>(node->inputs.size()));
+        for (const auto& pin : node->inputs) out.put<int32_t>(pin.id);
+        out.put<uint16_t>(static_cast<uint16_t>(node->outputs.size()));
+        for (const auto& pin : node->outputs) out.put<int32_t>(pin.id);
+        if (hasLayout) {
+            ImVec2 pos = ImNodes::GetNodeGridSpacePos(node->id);
+            out.put(pos.x);
+            out.put(pos.y);
+        }
+        size_t block = out.beginBlock();
+        BinaryParamWriter params(out);
+        params.field("frozen", node->frozen); // Editor state, saved with the node's parameters
+        node->serializeParams(params);
+        out.endBlock(block);
+    }
+
+    for (const auto& conn : editor.connections) {
+        out.put<int32_t>(conn.outputPin);
+        out.put<int32_t>(conn.inputPin);
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.write(out.buffer.data(), static_cast<std::streamsize>(out.buffer.size()))) {
+        std::cerr << "Cannot write graph: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool GraphSerializer::exportJson(const NodeEditor& editor, const std::string& path) {
+    cv::FileStorage fs(path, cv::FileStorage::WRITE | cv::FileStorage::FORMAT_JSON);
+    if (!fs.isOpened()) {
+        std::cerr << "Cannot write graph: " << path << std::endl;
+        return false;
+    }
+
+    const bool hasLayout = ImNodes::GetCurrentContext() != nullptr;
+
+    fs << "version" << kJsonVersion;
+    fs << "nextId" << editor.currentId;
+    fs << "depthBits" << depthBits(editor.workingDepth);
+
+    fs << "nodes" << "[";
+    for (const auto& node : editor.nodes) {
+        fs << "{";
+        fs << "type" << node->name;
+        fs << "id" << node->id;
+        writePinIds(fs, "inputs", node->inputs);
+        writePinIds(fs, "outputs", node->outputs);
+        if (hasLayout) {
+            ImVec2 pos = ImNodes::GetNodeGridSpacePos(node->id);
+            fs << "x" << pos.x << "y" << pos.y;
+        }
+        fs << "params" << "{";
+        JsonParamWriter params(fs);
+        params.field("frozen", node->frozen); // Editor state, saved with the node's parameters
+        node->serializeParams(params);
+        fs << "}";
+        fs << "}";
+    }
+    fs << "]";
+
+    fs << "connections" << "[";
+    for (const auto& conn : editor.connections) {
+        fs << "{" << "outputPin" << conn.outputPin << "inputPin" << conn.inputPin << "}";
+    }
+    fs << "]";
+    return true;
+}
+
+bool GraphSerializer::load(NodeEditor& editor, const std::string& path) {
+    editor.clear();
+    DiskCache::instance().setDirectory(DiskCache::directoryFor(path));
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Cannot read graph: " << path << std::endl;
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    if (data.size() >= sizeof(kMagic) && std::memcmp(data.data(), kMagic, sizeof(kMagic)) == 0) {
+        return loadBinary(editor, data, path);
+    }
+    return loadJson(editor, path);
+}
+
+bool GraphSerializer::loadBinary(NodeEditor& editor, const std::string& data, const std::string& path) {
+    BinaryReader in(data.data() + sizeof(kMagic), data.size() - sizeof(kMagic));
+    uint32_t version = in.get<uint32_t>();
+    if (!in.ok() || version < 1 || version > kBinaryVersion) {
+        std::cerr << "Unsupported graph version " << version << " in " << path << std::endl;
+        return false;
+    }
+    uint32_t flags = in.get<uint32_t>();
+    int32_t nextId = in.get<int32_t>();
+    uint32_t nodeCount = in.get<uint32_t>();
+    uint32_t connectionCount = in.get<uint32_t>();
+    // Older files predate the setting and were always processed in 8 bits
+    editor.setWorkingDepth(version >= 2 ? depthFromBits(in.get<uint8_t>()) : CV_8U);
+
+    const bool withLayout = (flags & kFlagLayout) && ImNodes::GetCurrentContext();
+    int maxId = -1;
+
+    // Counts come from the file, so only reserve what the data could actually hold
+    editor.nodes.reserve(std::min<size_t>(nodeCount, data.size() / 16));
+    editor.nodeIndex.reserve(editor.nodes.capacity());
+
+    for (uint32_t n = 0; n < nodeCount && in.ok(); ++n) {
+        std::string typeName = in.getString();
+        std::unique_ptr<BaseNode> node(createNode(editor, typeName));
+        if (!node) {
+            std::cerr << "Unknown node type '" << typeName << "' in " << path << " (plugin not loaded?)" << std::endl;
+            editor.clear();
+            return false;
+        }
+        node->id = in.get<int32_t>();
+        bool pinsOk = readPinIds(in, node->inputs) && readPinIds(in, node->outputs);
+        float x = 0.0f, y = 0.0f;
+        if (flags & kFlagLayout) {
+            x = in.get<float>();
+            y = in.get<float>();
+        }
+        uint32_t paramBytes = in.get<uint32_t>();
+        const char* params = in.take(paramBytes);
+        if (!pinsOk || !in.ok()) {
+            std::cerr << "Malformed node '" << typeName << "' in " << path << std::endl;
+            editor.clear();
+            return false;
+        }
+
+        BinaryParamReader reader(params, paramBytes);
+        reader.field("frozen", node->frozen);
+        node->serializeParams(reader);
+        if (withLayout) ImNodes::SetNodeGridSpacePos(node->id, ImVec2(x, y));
+        if (!addLoadedNode(editor, std::move(node), maxId, path)) return false;
+    }
+
+    editor.connections.reserve(std::min<size_t>(connectionCount, data.size() / 8));
+    for (uint32_t c = 0; c < connectionCount && in.ok(); ++c) {
+        int32_t outputPin = in.get<int32_t>();
+        int32_t inputPin = in.get<int32_t>();
+        if (in.ok()) addLoadedConnection(editor, outputPin, inputPin, path);
+    }
+
+    if (version <= 2) {
+        // Checking a stored order costs as much as sorting, so it is ignored
+        uint32_t orderCount = in.get<uint32_t>();
+        for (uint32_t k = 0; k < orderCount && in.ok(); ++k) in.get<uint32_t>();
+    }
+
+    if (!in.ok()) {
+        std::cerr << "Truncated graph file: " << path << std::endl;
+        editor.clear();
+        return false;
+    }
+
+    editor.currentId = std::max<int>(nextId, maxId + 1);
+    editor.invalidateTopology();
+    return true;
+}
+
+bool GraphSerializer::loadJson(NodeEditor& editor, const std::string& path) {
+    cv::FileStorage fs;
+    try {
+        fs.open(path, cv::FileStorage::READ | cv::FileStorage::FORMAT_JSON);
+    } catch (const cv::Exception& e) {
+        std::cerr << "Cannot parse graph " << path << ": " << e.what() << std::endl;
+        return false;
+    }
+    if (!fs.isOpened()) {
+        std::cerr << "Cannot read graph: " << path << std::endl;
+        return false;
+    }
+
+    int version = 0;
+    cv::read(fs["version"], version, 0);
+    if (version < 1 || version > kJsonVersion) {
+        std::cerr << "Unsupported graph version " << version << " in " << path << std::endl;
+        return false;
+    }
+
+    int bits = 8;
+    cv::read(fs["depthBits"], bits, 8);
+    editor.setWorkingDepth(depthFromBits(bits));
+
+    const bool hasLayout = ImNodes::GetCurrentContext() != nullptr;
+    int maxId = -1;
+
+    for (const auto& entry : fs["nodes"]) {
+        std::string typeName;
+        cv::read(entry["type"], typeName, std::string());
+        std::unique_ptr<BaseNode> node(createNode(editor, typeName));
+        if (!node) {
+            std::cerr << "Unknown node type '" << typeName << "' in " << path << " (plugin not loaded?)" << std::endl;
+            editor.clear();
+            return false;
+        }
+
+        cv::read(entry["id"], node->id, -1);
+        if (!readPinIds(entry["inputs"], node->inputs) ||
+            !readPinIds(entry["outputs"], node->outputs)) {
+            std::cerr << "Malformed node '" << typeName << "' in " << path << std::endl;
+            editor.clear();
+            return false;
+        }
+
+        JsonParamReader reader(entry["params"]);
+        reader.field("frozen", node->frozen);
+        node->serializeParams(reader);
+        if (hasLayout && !entry["x"].empty()) {
+            ImNodes::SetNodeGridSpacePos(node->id, ImVec2(static_cast<float>(entry["x"]),
+                                                          static_cast<float>(entry["y"])));
+        }
+        if (!addLoadedNode(editor, std::move(node), maxId, path)) return false;
+    }
+
+    for (const auto& entry : fs["connections"]) {
+        int outputPin = -1, inputPin = -1;
+        cv::read(entry["outputPin"], outputPin, -1);
+        cv::read(entry["inputPin"], inputPin, -1);
+        addLoadedConnection(editor, outputPin, inputPin, path);
+    }
+
+    int nextId = 0;
+    cv::read(fs["nextId"], nextId, 0);
+    editor.currentId = std::max(nextId, maxId + 1);
+    editor.invalidateTopology();
+    return true;
+}
+
+// Nodes are identified in files by their display name (see NodeRegistry)
+BaseNode* GraphSerializer::createNode(NodeEditor& editor, const std::string& typeName) {
+    return editor.createNode(typeName);
+}
+
+bool GraphSerializer::addLoadedNode(NodeEditor& editor, std::unique_ptr<BaseNode> node,
+                                    int& maxId, const std::string& path) {
+    bool duplicate = node->id < 0 || editor.nodeIndex.count(node->id) > 0;
+    for (const auto* pins : {&node->inputs, &node->outputs}) {
+        for (const auto& pin : *pins) {
+            duplicate |= editor.pinIndex.count(pin.id) > 0;
+            maxId = std::max(maxId, pin.id);
+        }
+    }
+    if (duplicate) {
+        std::cerr << "Invalid or duplicate id on node " << node->id << " in " << path << std::endl;
+        editor.clear();
+        return false;
+    }
+    maxId = std::max(maxId, node->id);
+    node->dirty = true;
+
+    editor.nodes.emplace_back(std::move(node));
+    editor.indexNode(editor.nodes.size() - 1);
+    return true;
+}
+
+void GraphSerializer::addLoadedConnection(NodeEditor& editor, int outputPin, int inputPin,
+                                          const std::string& path) {
+    BaseNode* outputNode = editor.findNodeByPin(outputPin, false);
+    BaseNode* inputNode = editor.findNodeByPin(inputPin, true);
+    if (!outputNode || !inputNode) {
+        std::cerr << "Skipping link with unknown pins " << outputPin
+                  << " -> " << inputPin << " in " << path << std::endl;
+        return;
+    }
+    editor.connections.push_back({inputNode->id, outputNode->id, inputPin, outputPin});
+}
@@ -0,0 +1,124 @@
+// ImageCache.cpp
+// Shared, memory-bounded LRU cache of decoded images keyed by path + mtime/size
+#include "ImageCache.hpp"
+#include <opencv2/imgcodecs.hpp>
+#include <filesystem>
+
+namespace {
+thread_local ImageCache::Counters lookups;
+}
+
+ImageCache::Counters ImageCache::threadCounters() {
+    return lookups;
+}
+
+ImageCache& ImageCache::instance() {
+    static ImageCache cache;
+    return cache;
+}
+
+bool ImageCache::readStamp(const std::string& path, Stamp& stamp) {
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) return false;
+    auto size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+
+    stamp.mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+    stamp.size = size;
+    return true;
+}
+
+bool ImageCache::hasChanged(const std::string& path, const Stamp& stamp) {
+    Stamp current;
+    if (!readStamp(path, current)) return true;
+    return current != stamp;
+}
+
+cv::Mat ImageCache::load(const std::string& path, Stamp* stamp) {
+    Stamp current;
+    if (!readStamp(path, current)) {
+        return cv::Mat();
+    }
+    if (stamp) *stamp = current;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(path);
+        if (it != index.end()) {
+            if (it->second->stamp == current) {
+                // Hit: move to the front of the LRU list
+                lru.splice(lru.begin(), lru, it->second);
+                ++lookups.hits;
+                return it->second->image;
+            }
+            // File changed on disk: drop the outdated entry
+            usedBytes -= it->second->bytes;
+            lru.erase(it->second);
+            index.erase(it);
+        }
+    }
+
+    ++lookups.misses;
+
+    // Decode outside the lock so other inputs are not serialized behind us
+    // At the file's own depth; 16-bit and float files are not rounded to 8 bits
+    cv::Mat image = cv::imread(path, cv::IMREAD_COLOR | cv::IMREAD_ANYDEPTH);
+    if (image.empty()) {
+        return image;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(path);
+    if (it != index.end()) {
+        // Another caller decoded the same file concurrently; keep one copy
+        usedBytes -= it->second->bytes;
+        lru.erase(it->second);
+        index.erase(it);
+    }
+
+    Entry entry;
+    entry.path = path;
+    entry.stamp = current;
+    entry.image = image;
+    entry.bytes = image.total() * image.elemSize();
+    usedBytes += entry.bytes;
+    lru.push_front(std::move(entry));
+    index[path] = lru.begin();
+    evictLocked();
+
+    return image;
+}
+
+void ImageCache::evictLocked() {
+    // Never evict the entry that was just inserted, even if it alone exceeds the budget
+    while (usedBytes > budgetBytes && lru.size() > 1) {
+        const Entry& victim = lru.back();
+        usedBytes -= victim.bytes;
+        index.erase(victim.path);
+        lru.pop_back();
+    }
+}
+
+void ImageCache::setBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    budgetBytes = bytes;
+    evictLocked();
+}
+
+size_t ImageCache::budget() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return budgetBytes;
+}
+
+size_t ImageCache::usage() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return usedBytes;
+}
+
+void ImageCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    lru.clear();
+    index.clear();
+    usedBytes = 0;
+}
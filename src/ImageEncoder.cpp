@@ -0,0 +1,99 @@
+// ImageEncoder.cpp
+// Threaded image writing for Output nodes and the batch runner
+#include "ImageEncoder.hpp"
+#include "BaseNode.hpp"
+#include <opencv2/imgcodecs.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+ImageEncoder::ImageEncoder(unsigned threads, size_t queueCapacity)
+    : queue(queueCapacity ? queueCapacity : 2 * std::max(1u, threads)) {
+    threads = std::max(1u, threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back(&ImageEncoder::workerLoop, this);
+    }
+}
+
+ImageEncoder::~ImageEncoder() {
+    finish();
+}
+
+ImageEncoder& ImageEncoder::shared() {
+    // A few saves at a time are plenty for interactive use
+    static ImageEncoder encoder(2, 16);
+    return encoder;
+}
+
+void ImageEncoder::enableOpenExr() {
+#ifdef _WIN32
+    if (!std::getenv("OPENCV_IO_ENABLE_OPENEXR")) _putenv_s("OPENCV_IO_ENABLE_OPENEXR", "1");
+#else
+    setenv("OPENCV_IO_ENABLE_OPENEXR", "1", 0);
+#endif
+}
+
+std::future<bool> ImageEncoder::submit(Job job) {
+    Pending pending;
+    pending.job = std::move(job);
+    std::future<bool> result = pending.done.get_future();
+    if (!queue.push(std::move(pending))) {
+        // Already finished; the promise went down with the rejected item
+        std::promise<bool> rejected;
+        rejected.set_value(false);
+        return rejected.get_future();
+    }
+    return result;
+}
+
+void ImageEncoder::finish() {
+    queue.close();
+    for (auto& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void ImageEncoder::workerLoop() {
+    Pending pending;
+    while (queue.pop(pending)) {
+        bool ok = write(pending.job);
+        if (!ok) ++failed;
+        pending.done.set_value(ok);
+        if (onJobDone) onJobDone();
+    }
+}
+
+bool ImageEncoder::write(const Job& job) {
+    if (job.image.empty()) return false;
+
+    std::error_code ec;
+    fs::path target(job.path);
+    if (target.has_parent_path()) fs::create_directories(target.parent_path(), ec);
+
+    std::string ext = target.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    // Each codec takes only some depths; others are rescaled to the closest
+    // one it stores. OpenEXR is floating point only, PNG stops at 16 bits
+    // and JPEG and BMP at 8; TIFF takes every working depth as it is.
+    cv::Mat image = job.image;
+    const int depth = image.depth();
+    int stored = CV_8U;
+    if (ext == ".exr") stored = CV_32F;
+    else if (ext == ".png") stored = depth == CV_8U ? CV_8U : CV_16U;
+    else if (ext == ".tif" || ext == ".tiff") stored = depth == CV_8U || depth == CV_16U ? depth : CV_32F;
+    image = BaseNode::convertDepth(image, stored);
+
+    try {
+        if (cv::imwrite(job.path, image, job.params)) return true;
+    } catch (const cv::Exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+    std::cerr << "Cannot write " << job.path << std::endl;
+    return false;
+}
@@ -0,0 +1,193 @@
+// ImageStats.cpp
+// One-pass gray statistics shared through Pin::stats()
+#include "ImageStats.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <limits>
+#include <vector>
+
+namespace {
+
+constexpr int kBins = ImageStats::kBins;
+
+// 8 bits: the histogram alone gives the range and the sum exactly. Four
+// interleaved tables keep runs of equal pixels from waiting on one counter.
+void count8u(const cv::Mat& gray, int begin, int end, ImageStats& stats) {
+    std::vector<uint32_t> tables(4 * kBins, 0);
+    uint32_t* t0 = tables.data();
+    uint32_t* t1 = t0 + kBins;
+    uint32_t* t2 = t1 + kBins;
+    uint32_t* t3 = t2 + kBins;
+    for (int y = begin; y < end; y++) {
+        const unsigned char* row = gray.ptr<unsigned char>(y);
+        int x = 0;
+        for (; x + 4 <= gray.cols; x += 4) {
+            t0[row[x]]++;
+            t1[row[x + 1]]++;
+            t2[row[x + 2]]++;
+            t3[row[x + 3]]++;
+        }
+        for (; x < gray.cols; x++) t0[row[x]]++;
+    }
+
+    int lowest = -1, highest = -1;
+    for (int b = 0; b < kBins; b++) {
+        const uint64_t n = uint64_t(t0[b]) + t1[b] + t2[b] + t3[b];
+        if (n == 0) continue;
+        if (lowest < 0) lowest = b;
+        highest = b;
+        stats.histogram[b] = n;
+        stats.count += n;
+        stats.sum += static_cast<double>(b) * n;
+    }
+    if (lowest >= 0) {
+        stats.min = lowest;
+        stats.max = highest;
+    }
+}
+
+void count16u(const cv::Mat& gray, int begin, int end, ImageStats& stats) {
+    unsigned lowest = std::numeric_limits<unsigned short>::max(), highest = 0;
+    uint64_t sum = 0;
+    for (int y = begin; y < end; y++) {
+        const unsigned short* row = gray.ptr<unsigned short>(y);
+        for (int x = 0; x < gray.cols; x++) {
+            const unsigned v = row[x];
+            stats.histogram[v >> 8]++;
+            lowest = std::min(lowest, v);
+            highest = std::max(highest, v);
+            sum += v;
+        }
+    }
+    stats.count = static_cast<uint64_t>(end - begin) * gray.cols;
+    stats.sum = static_cast<double>(sum);
+    if (stats.count) {
+        stats.min = lowest;
+        stats.max = highest;
+    }
+}
+
+void count32f(const cv::Mat& gray, int begin, int end, ImageStats& stats) {
+    float lowest = std::numeric_limits<float>::max(), highest = -std::numeric_limits<float>::max();
+    for (int y = begin; y < end; y++) {
+        const float* row = gray.ptr<float>(y);
+        double rowSum = 0.0; // Per row, so long images keep their precision
+        for (int x = 0; x < gray.cols; x++) {
+            const float v = row[x];
+            if (v != v) continue;
+            const float scaled = v * kBins;
+            const int b = scaled <= 0.0f ? 0 : scaled >= kBins - 1 ? kBins - 1 : static_cast<int>(scaled);
+            stats.histogram[b]++;
+            lowest = std::min(lowest, v);
+            highest = std::max(highest, v);
+            rowSum += v;
+            stats.count++;
+        }
+        stats.sum += rowSum;
+    }
+    if (stats.count) {
+        stats.min = lowest;
+        stats.max = highest;
+    }
+}
+
+} // namespace
+
+ImageStats ImageStats::of(const cv::Mat& image) {
+    CV_Assert(image.channels() == 1);
+    cv::Mat gray = image;
+    if (gray.depth() != CV_8U && gray.depth() != CV_16U && gray.depth() != CV_32F) {
+        image.convertTo(gray, CV_32F);
+    }
+
+    ImageStats total;
+    total.depth = gray.depth();
+    if (gray.empty()) return total;
+
+    // Fixed stripes merged in order, so the sums never depend on scheduling
+    const int stripes = std::max(1, std::min(gray.rows, 4 * std::max(1, cv::getNumThreads())));
+    std::vector<ImageStats> partial(stripes);
+    cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+        for (int s = range.start; s < range.end; s++) {
+            const int begin = static_cast<int>(static_cast<int64_t>(gray.rows) * s / stripes);
+            const int end = static_cast<int>(static_cast<int64_t>(gray.rows) * (s + 1) / stripes);
+            ImageStats& part = partial[s];
+            part.depth = gray.depth();
+            switch (gray.depth()) {
+                case CV_8U:  count8u(gray, begin, end, part); break;
+                case CV_16U: count16u(gray, begin, end, part); break;
+                default:     count32f(gray, begin, end, part); break;
+            }
+        }
+    });
+    for (const auto& part : partial) total.merge(part);
+    return total;
+}
+
+void ImageStats::merge(const ImageStats& other) {
+    if (other.count == 0) return;
+    if (count == 0) {
+        min = other.min;
+        max = other.max;
+        depth = other.depth;
+    } else {
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+    }
+    for (int b = 0; b < kBins; b++) histogram[b] += other.histogram[b];
+    count += other.count;
+    sum += other.sum;
+}
+
+double ImageStats::binWidth() const {
+    switch (depth) {
+        case CV_8U:  return 1.0;
+        case CV_16U: return 256.0;
+        default:     return 1.0 / kBins;
+    }
+}
+
+// The search cv::threshold runs for THRESH_OTSU on 8 bits: the bin that
+// maximizes the variance between the two classes
+double ImageStats::otsuThreshold() const {
+    if (count == 0) return 0.0;
+    const double scale = 1.0 / count;
+    double mu = 0.0;
+    for (int i = 0; i < kBins; i++) mu += i * static_cast<double>(histogram[i]);
+    mu *= scale;
+
+    double mu1 = 0.0, q1 = 0.0;
+    double maxSigma = 0.0;
+    int best = 0;
+    for (int i = 0; i < kBins; i++) {
+        const double p = histogram[i] * scale;
+        mu1 *= q1;
+        q1 += p;
+        const double q2 = 1.0 - q1;
+        if (std::min(q1, q2) < FLT_EPSILON || std::max(q1, q2) > 1.0 - FLT_EPSILON) continue;
+        mu1 = (mu1 + i * p) / q1;
+        const double mu2 = (mu - q1 * mu1) / q2;
+        const double sigma = q1 * q2 * (mu1 - mu2) * (mu1 - mu2);
+        if (sigma > maxSigma) {
+            maxSigma = sigma;
+            best = i;
+        }
+    }
+
+    // Everything in bins up to best is background
+    switch (depth) {
+        case CV_8U:  return best;
+        case CV_16U: return best * 256.0 + 255.0;
+        default:     return (best + 1) * binWidth();
+    }
+}
+
+std::array<float, ImageStats::kBins> ImageStats::normalized() const {
+    std::array<float, kBins> bins{};
+    const uint64_t tallest = *std::max_element(histogram.begin(), histogram.end());
+    if (tallest == 0) return bins;
+    for (int b = 0; b < kBins; b++) {
+        bins[b] = static_cast<float>(static_cast<double>(histogram[b]) / tallest);
+    }
+    return bins;
+}
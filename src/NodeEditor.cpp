@@ -1,23 +1,45 @@
 #include <imgui.h>
 #include <imnodes.h>
+#include "portable-file-dialogs.h"
 #include "NodeEditor.hpp"
-#include "nodes/ImageInputNode.hpp"
-#include "nodes/OutputNode.hpp"
-#include "nodes/BrightnessContrastNode.hpp"
-#include "nodes/ColorChannelSplitterNode.hpp"
-#include "nodes/BlurNode.hpp"
-#include "nodes/ThresholdNode.hpp"
-#include "nodes/EdgeDetectionNode.hpp"
-#include "nodes/BlendNode.hpp"
-#include "nodes/NoiseNode.hpp"
-#include "nodes/ConvolutionNode.hpp"
+#include "BufferPool.hpp"
+#include "DiskCache.hpp"
+#include "ImageCache.hpp"
+#include "PreviewTexture.hpp"
+#include "NodeRegistry.hpp"
+#include "ThreadPool.hpp"
+#include "TiledEvaluator.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <mutex>
 #include <unordered_set>  
 
-NodeEditor::NodeEditor() {
-    ImNodes::GetIO().LinkDetachWithModifierClick.Modifier = &ImGui::GetIO().KeyCtrl;
+NodeEditor::NodeEditor() : pool(std::make_shared<ThreadPool>()) {
+    // The batch runner evaluates graphs without any UI context
+    if (ImNodes::GetCurrentContext()) {
+        ImNodes::GetIO().LinkDetachWithModifierClick.Modifier = &ImGui::GetIO().KeyCtrl;
+    }
+    evaluator = std::thread(&NodeEditor::evaluatorLoop, this);
 }
 
 NodeEditor::~NodeEditor() {
+    shutdown();
+}
+
+void NodeEditor::shutdown() {
+    if (!evaluator.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopEvaluator = true;
+        if (runningJob) runningJob->cancelled = true;
+    }
+    jobReady.notify_one();
+    evaluator.join();
+    onResultsReady = nullptr;
     clear();
 }
 
@@ -30,6 +52,11 @@ void NodeEditor::draw() {
 
         ImNodes::BeginNodeTitleBar();
         ImGui::TextUnformatted(node->name.c_str());
+        NodeProfiler::NodeStats stats;
+        if (profiler.stats(node->id, stats)) {
+            ImGui::SameLine();
+            ImGui::TextDisabled("%.1f ms", stats.lastMs);
+        }
         ImNodes::EndNodeTitleBar();
 
         // Input pins
@@ -47,6 +74,16 @@ void NodeEditor::draw() {
         }
 
         node->drawUI();
+
+        if (!node->outputs.empty()) {
+            ImGui::PushID(node->id);
+            bool frozen = node->frozen;
+            if (ImGui::Checkbox("Cache to disk", &frozen)) setFrozen(node.get(), frozen);
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Keeps this node's results on disk and ignores upstream changes");
+            }
+            ImGui::PopID();
+        }
         ImNodes::EndNode();
     }
 
@@ -72,6 +109,19 @@ void NodeEditor::draw() {
     int hoveredNodeId = -1;
     if (ImNodes::IsNodeHovered(&hoveredNodeId) && 
         ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
+        // Detach downstream consumers so they recompute without this input
+        for (const auto& conn : connections) {
+            if (conn.outputNode != hoveredNodeId) continue;
+            if (auto* consumer = findNodeById(conn.inputNode)) {
+                int pinIdx = findPinIndex(consumer->inputs, conn.inputPin);
+                if (pinIdx >= 0) {
+                    consumer->inputs[pinIdx].data.release();
+                    consumer->inputs[pinIdx].connected = false;
+                }
+                consumer->dirty = true;
+            }
+        }
+
         // Remove associated connections
         connections.erase(
             std::remove_if(connections.begin(), connections.end(),
@@ -87,14 +137,27 @@ void NodeEditor::draw() {
                 return node->id == hoveredNodeId;
             });
         if (it != nodes.end()) {
+            if ((*it)->frozen) DiskCache::instance().remove((*it)->id, (*it)->outputs.size());
             nodes.erase(it);
-            processGraph();
         }
+        profiler.forget(hoveredNodeId);
+        memo.forget(hoveredNodeId);
+
+        // Indices behind the erased node shifted
+        rebuildIndex();
     }
 
     handleConnections();
 }
 
+// Either way the node runs again: freezing writes fresh files from the
+// current upstream, unfreezing recomputes from whatever upstream is now
+void NodeEditor::setFrozen(BaseNode* node, bool frozen) {
+    DiskCache::instance().remove(node->id, node->outputs.size());
+    node->frozen = frozen;
+    node->dirty = true;
+}
+
 void NodeEditor::deleteConnection(int connectionIndex) {
     if (connectionIndex < 0 || connectionIndex >= static_cast<int>(connections.size())) return;
 
@@ -108,6 +171,7 @@ void NodeEditor::deleteConnection(int connectionIndex) {
                 pin.connected = false;
             }
         }
+        inputNode->dirty = true;
     }
     
     if (auto* outputNode = findNodeById(conn.outputNode)) {
@@ -119,7 +183,7 @@ void NodeEditor::deleteConnection(int connectionIndex) {
     }
 
     connections.erase(connections.begin() + connectionIndex);
-    processGraph();
+    invalidateTopology();
 }
 
 
@@ -133,36 +197,30 @@ bool NodeEditor::isConnectionValid(const Connection& conn) {
 void NodeEditor::handleConnections() {
     int startPin, endPin;
     if (ImNodes::IsLinkCreated(&startPin, &endPin)) {
-        BaseNode* outputNode = findNodeByPin(startPin, false);
-        BaseNode* inputNode = findNodeByPin(endPin, true);
-        
-        if (outputNode && inputNode) {
-            // This is where connections should be stored
-            connections.push_back({
-                inputNode->id,
-                outputNode->id,
-                endPin,
-                startPin
-            });
-            
+        if (connect(startPin, endPin)) {
             std::cout << "Connection created: " << connections.size() << " total connections" << std::endl;
-            
-            // Mark for processing
-            outputNode->dirty = true;
-            inputNode->dirty = true;
         }
     }
 }
 
+bool NodeEditor::connect(int outputPin, int inputPin) {
+    BaseNode* outputNode = findNodeByPin(outputPin, false);
+    BaseNode* inputNode = findNodeByPin(inputPin, true);
+    if (!outputNode || !inputNode) return false;
+
+    connections.push_back({inputNode->id, outputNode->id, inputPin, outputPin});
+    invalidateTopology();
+
+    // Only the consumer needs recomputing; the producer's output is unchanged
+    inputNode->dirty = true;
+    return true;
+}
+
 
 
 BaseNode* NodeEditor::findNodeById(int nodeId) {
-    for (auto& node : nodes) {
-        if (node->id == nodeId) {
-            return node.get();
-        }
-    }
-    return nullptr;
+    auto it = nodeIndex.find(nodeId);
+    return it != nodeIndex.end() ? nodes[it->second].get() : nullptr;
 }
 
 int NodeEditor::findPinIndex(const std::vector<Pin>& pins, int pinId) {
@@ -178,109 +236,850 @@ int NodeEditor::findPinIndex(const std::vector<Pin>& pins, int pinId) {
 
 
 BaseNode* NodeEditor::findNodeByPin(int pinId, bool isInput) {
+    auto it = pinIndex.find(pinId);
+    if (it == pinIndex.end() || it->second.isInput != isInput) {
+        return nullptr;
+    }
+    return nodes[it->second.node].get();
+}
+
+void NodeEditor::indexNode(size_t idx) {
+    const BaseNode* node = nodes[idx].get();
+    nodeIndex[node->id] = idx;
+    for (size_t i = 0; i < node->inputs.size(); ++i) {
+        pinIndex[node->inputs[i].id] = {idx, static_cast<int>(i), true};
+    }
+    for (size_t i = 0; i < node->outputs.size(); ++i) {
+        pinIndex[node->outputs[i].id] = {idx, static_cast<int>(i), false};
+    }
+}
+
+void NodeEditor::rebuildIndex() {
+    nodeIndex.clear();
+    pinIndex.clear();
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        indexNode(i);
+    }
+    invalidateTopology();
+}
+
+std::shared_ptr<const NodeEditor::Topology> NodeEditor::currentTopology() {
+    if (topology) return topology;
+
+    auto graph = std::make_shared<Topology>();
+    const size_t count = nodes.size();
+    graph->incoming.resize(count);
+    graph->outgoing.resize(count);
+
+    for (const auto& conn : connections) {
+        auto from = pinIndex.find(conn.outputPin);
+        auto to = pinIndex.find(conn.inputPin);
+        if (from == pinIndex.end() || to == pinIndex.end()) continue;
+
+        const PinLocation& out = from->second;
+        const PinLocation& in = to->second;
+        graph->incoming[in.node].push_back({out.node, out.pin, in.pin});
+        graph->outgoing[out.node].push_back(in.node);
+    }
+
+    // Topological order (Kahn); nodes that are part of a cycle are never scheduled
+    std::vector<size_t> inDegree(count);
+    graph->order.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        inDegree[i] = graph->incoming[i].size();
+        if (inDegree[i] == 0) graph->order.push_back(i);
+    }
+    for (size_t k = 0; k < graph->order.size(); ++k) {
+        for (size_t next : graph->outgoing[graph->order[k]]) {
+            if (--inDegree[next] == 0) graph->order.push_back(next);
+        }
+    }
+
+    topology = graph;
+    return topology;
+}
+
+void NodeEditor::pruneConnections() {
+    auto valid = std::remove_if(connections.begin(), connections.end(),
+        [this](const Connection& conn) {
+            return !this->isConnectionValid(conn);
+        });
+    if (valid != connections.end()) {
+        connections.erase(valid, connections.end());
+        invalidateTopology();
+    }
+}
+
+void NodeEditor::processGraph() {
+    pruneConnections();
+    useFullResolution();
+    evaluateGraph(nodes, *currentTopology(), nullptr, nullptr);
+}
+
+void NodeEditor::processGraphTiled(int tileSize) {
+    TiledEvaluator::run(*this, tileSize);
+}
+
+void NodeEditor::evaluateAsync() {
+    collectResults();
+    pruneConnections();
+
+    bool changed = false;
     for (auto& node : nodes) {
-        if (isInput) {
-            for (auto& pin : node->inputs) {
-                if (pin.id == pinId) {
-                    return node.get();
+        if (node->dirty) {
+            // Remember the change until a finished evaluation covers it
+            unresolvedDirty.insert(node->id);
+            node->dirty = false;
+            changed = true;
+        }
+    }
+
+    // Edits are evaluated on proxies. Once they pause and the last proxy
+    // pass is in, the same graph runs again at full resolution.
+    const auto now = NodeProfiler::Clock::now();
+    double scale = 1.0;
+    if (changed) {
+        lastEdit = now;
+        scale = proxyScaleFor();
+    } else {
+        bool proxied = std::any_of(nodes.begin(), nodes.end(),
+            [](const std::unique_ptr<BaseNode>& node) { return node->proxyScale != 1.0; });
+        if (!proxied || now - lastEdit < kRefineDelay || isEvaluating()) return;
+    }
+
+    auto job = std::make_unique<EvaluationJob>();
+    job->generation = ++latestGeneration;
+    job->scale = scale;
+    job->topology = currentTopology();
+    job->nodes.reserve(nodes.size());
+    for (const auto& node : nodes) {
+        std::unique_ptr<BaseNode> copy(node->clone());
+        // Also re-covers nodes of a superseded job that never finished, and
+        // nodes whose current results were computed at another scale
+        copy->dirty = unresolvedDirty.count(node->id) > 0 || node->proxyScale != scale;
+        copy->proxyScale = scale;
+        job->nodes.emplace_back(std::move(copy));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        if (runningJob) runningJob->cancelled = true;
+        pendingJob = std::move(job); // Drops an older submission that never started
+    }
+    jobReady.notify_one();
+}
+
+bool NodeEditor::isEvaluating() const {
+    std::lock_guard<std::mutex> lock(jobMutex);
+    return runningJob != nullptr || pendingJob != nullptr;
+}
+
+double NodeEditor::idleTimeout() const {
+    double timeout = -1.0;
+    auto earliest = [&timeout](double seconds) {
+        if (seconds >= 0.0 && (timeout < 0.0 || seconds < timeout)) timeout = seconds;
+    };
+
+    const double now = ImGui::GetTime();
+    for (const auto& node : nodes) earliest(node->redrawIn(now));
+
+    // Mirrors the refine condition in evaluateAsync()
+    bool proxied = std::any_of(nodes.begin(), nodes.end(),
+        [](const std::unique_ptr<BaseNode>& node) { return node->proxyScale != 1.0; });
+    if (proxied && !isEvaluating()) {
+        const auto remaining = kRefineDelay - (NodeProfiler::Clock::now() - lastEdit);
+        earliest(std::max(0.0, std::chrono::duration<double>(remaining).count()));
+    }
+    return timeout;
+}
+
+void NodeEditor::evaluatorLoop() {
+    std::unique_lock<std::mutex> lock(jobMutex);
+    while (true) {
+        jobReady.wait(lock, [this] { return stopEvaluator || pendingJob != nullptr; });
+        if (stopEvaluator) return;
+
+        std::unique_ptr<EvaluationJob> job = std::move(pendingJob);
+        runningJob = job.get();
+        lock.unlock();
+
+        evaluateGraph(job->nodes, *job->topology, &job->cancelled, &job->processed);
+
+        lock.lock();
+        runningJob = nullptr;
+        if (!job->cancelled) {
+            completedJob = std::move(job);
+            if (onResultsReady) {
+                lock.unlock();
+                onResultsReady();
+                lock.lock();
+            }
+        }
+    }
+}
+
+void NodeEditor::collectResults() {
+    std::unique_ptr<EvaluationJob> job;
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        job = std::move(completedJob);
+    }
+
+    // Results of a superseded snapshot are discarded; the newer job is on its way
+    if (!job || job->generation != latestGeneration) return;
+
+    // Snapshot nodes were cloned in order, but the live graph may have changed since
+    std::unordered_map<int, const BaseNode*> evaluatedById;
+    for (const auto& node : job->nodes) {
+        evaluatedById[node->id] = node.get();
+    }
+
+    for (int id : job->processed) {
+        BaseNode* live = findNodeById(id);
+        if (live) {
+            live->adoptResults(*evaluatedById[id]);
+        }
+    }
+    // Nodes the job did not recompute already held results at its scale
+    for (const auto& node : nodes) {
+        if (evaluatedById.count(node->id)) node->proxyScale = job->scale;
+    }
+    unresolvedDirty.clear();
+}
+
+// Largest power of two reduction that keeps the widest source at least
+// proxyWidth pixels wide; 1 when the sources are small enough already
+double NodeEditor::proxyScaleFor() const {
+    if (proxyWidth <= 0) return 1.0;
+    int widest = 0;
+    for (const auto& node : nodes) {
+        widest = std::max(widest, node->sourceSize().width);
+    }
+    double scale = 1.0;
+    while (widest * scale * 0.5 >= proxyWidth) scale *= 0.5;
+    return scale;
+}
+
+void NodeEditor::useFullResolution() {
+    for (auto& node : nodes) {
+        if (node->proxyScale != 1.0) {
+            node->proxyScale = 1.0;
+            node->dirty = true;
+        }
+    }
+}
+
+void NodeEditor::evaluateGraph(std::vector<std::unique_ptr<BaseNode>>& graphNodes,
+                               const Topology& graphTopology,
+                               const std::atomic<bool>* cancelled,
+                               std::vector<int>* processedIds) {
+    const size_t count = graphNodes.size();
+    if (count == 0) return;
+
+    // Keep the pool alive for this pass even if the worker count changes meanwhile
+    std::shared_ptr<ThreadPool> workers = std::atomic_load(&pool);
+
+    const auto& incoming = graphTopology.incoming;
+    const auto& downstream = graphTopology.outgoing;
+
+    // Frozen nodes whose files on disk match their parameters stand in for
+    // everything upstream of them: changes there do not reach them
+    std::vector<char> fromDisk(count, 0);
+    for (size_t idx : graphTopology.order) {
+        BaseNode* node = graphNodes[idx].get();
+        fromDisk[idx] = node->frozen &&
+            DiskCache::instance().has(node->id, node->outputs.size(), frozenKey(node));
+    }
+
+    // Propagate dirtiness downstream and collect the subgraph to recompute.
+    // A producer whose output was elided by an earlier fused pass has to run
+    // again as well, which may pull in more of the graph.
+    std::vector<size_t> work;
+    for (bool again = true; again;) {
+        work.clear();
+        for (size_t idx : graphTopology.order) {
+            for (const InputLink& link : incoming[idx]) {
+                if (fromDisk[idx]) break;
+                if (graphNodes[link.producer]->dirty) {
+                    graphNodes[idx]->dirty = true;
+                    break;
                 }
             }
-        } else {
-            for (auto& pin : node->outputs) {
-                if (pin.id == pinId) {
-                    return node.get();
+            if (graphNodes[idx]->dirty) work.push_back(idx);
+        }
+        again = false;
+        for (size_t idx : work) {
+            if (fromDisk[idx]) continue;
+            for (const InputLink& link : incoming[idx]) {
+                BaseNode* producer = graphNodes[link.producer].get();
+                if (!producer->dirty && producer->outputs[link.outputPin].elided) {
+                    producer->dirty = true;
+                    again = true;
                 }
             }
         }
     }
-    return nullptr;
-}
 
+    // Dirty nodes that only feed frozen nodes are not run. Their outputs
+    // count as elided, so unfreezing a consumer runs them again.
+    std::vector<char> needed(count, 0);
+    for (auto it = work.rbegin(); it != work.rend(); ++it) {
+        const size_t idx = *it;
+        needed[idx] = downstream[idx].empty() ||
+            std::any_of(downstream[idx].begin(), downstream[idx].end(),
+                        [&](size_t c) { return needed[c] && !fromDisk[c]; });
+    }
+    work.erase(std::remove_if(work.begin(), work.end(), [&](size_t idx) {
+        if (needed[idx]) return false;
+        BaseNode* node = graphNodes[idx].get();
+        for (auto& output : node->outputs) {
+            output.data = cv::Mat();
+            output.gpu = cv::UMat();
+            output.elided = true;
+        }
+        node->dirty = false;
+        if (processedIds) processedIds->push_back(node->id);
+        return true;
+    }), work.end());
+    if (work.empty()) return;
 
-void NodeEditor::processGraph() {
-    connections.erase(std::remove_if(connections.begin(), connections.end(),
-        [this](const Connection& conn) {
-            return !this->isConnectionValid(conn);
-        }), connections.end());
-    
-    std::unordered_set<BaseNode*> processed;
+    // Runs of dirty pointwise nodes, each feeding only the next, are fused:
+    // the head runs the whole chain and the other members are not scheduled
+    const size_t none = static_cast<size_t>(-1);
+    std::vector<size_t> chainNext(count, none);
+    std::vector<char> chainMember(count, 0);
+    auto fusable = [&graphNodes](size_t idx) {
+        const BaseNode* node = graphNodes[idx].get();
+        return node->isPointwise() && node->inputs.size() == 1 && node->outputs.size() == 1 &&
+               !node->frozen;
+    };
+    for (size_t idx : work) {
+        if (!fusable(idx) || downstream[idx].size() != 1) continue;
+        size_t next = downstream[idx].front();
+        if (fusable(next) && incoming[next].size() == 1 && graphNodes[next]->dirty) {
+            chainNext[idx] = next;
+            chainMember[next] = 1;
+        }
+    }
 
-    for (auto& node : nodes) {
-        processNode(node.get(), processed);
+    // GPU-capable nodes run on the device; their results are downloaded only
+    // where a CPU node reads them or where they leave the graph
+    std::vector<Placement> placement(count);
+    const bool gpuPass = useGpu.load(std::memory_order_relaxed);
+    if (gpuPass) {
+        for (size_t idx : work) {
+            placement[idx].gpu = graphNodes[idx]->supportsGpu();
+        }
+        for (size_t idx : work) {
+            if (!placement[idx].gpu) continue;
+            const auto& consumers = downstream[idx];
+            placement[idx].hostOutputs = consumers.empty() ||
+                std::any_of(consumers.begin(), consumers.end(),
+                            [&placement](size_t c) { return !placement[c].gpu; });
+        }
+    }
+    for (size_t idx : work) {
+        const BaseNode* node = graphNodes[idx].get();
+        placement[idx].fromDisk = fromDisk[idx];
+        placement[idx].toDisk = node->frozen && !fromDisk[idx] && node->proxyScale == 1.0;
+        if (placement[idx].toDisk) placement[idx].hostOutputs = true;
+    }
+
+    // Liveness: without retention, an output that was recomputed because its
+    // inputs changed is released once every link reading it has been served.
+    // Released outputs count as elided, so a later pass that needs one again
+    // runs its producer.
+    const bool release = !retainIntermediates.load(std::memory_order_relaxed);
+    std::vector<std::atomic<int>> readersLeft(count);
+    std::vector<char> releasable(count, 0);
+    if (release) {
+        for (size_t idx : work) {
+            releasable[idx] = !downstream[idx].empty() && !fromDisk[idx] &&
+                std::any_of(incoming[idx].begin(), incoming[idx].end(),
+                            [&graphNodes](const InputLink& link) { return graphNodes[link.producer]->dirty; });
+            readersLeft[idx].store(static_cast<int>(downstream[idx].size()), std::memory_order_relaxed);
+        }
+    }
+
+    // A dirty node becomes ready once all of its dirty producers have run
+    std::vector<std::atomic<int>> pending(count);
+    size_t jobs = 0;
+    for (size_t idx : work) {
+        int waitingOn = 0;
+        for (const InputLink& link : incoming[idx]) {
+            if (graphNodes[link.producer]->dirty) ++waitingOn;
+        }
+        pending[idx].store(waitingOn, std::memory_order_relaxed);
+        if (!chainMember[idx]) ++jobs;
+    }
+
+    BufferPool::instance().resetPeak();
+    const auto passStart = NodeProfiler::Clock::now();
+    std::mutex doneMutex;
+    std::condition_variable done;
+    size_t remaining = jobs;
+
+    std::function<void(size_t)> run = [&](size_t idx) {
+        // OpenCL use is per-thread state in OpenCV; each worker takes this pass's setting
+        if (cv::ocl::useOpenCL() != gpuPass) cv::ocl::setUseOpenCL(gpuPass);
+
+        std::vector<size_t> chain{idx};
+        while (chainNext[chain.back()] != none) chain.push_back(chainNext[chain.back()]);
+
+        // A cancelled pass still walks the graph so that every waiter is released
+        if (!cancelled || !cancelled->load(std::memory_order_relaxed)) {
+            if (chain.size() > 1) {
+                processChain(chain, graphTopology, graphNodes, &profiler, &memo);
+            } else {
+                processNode(graphNodes[idx].get(), incoming[idx], graphNodes, &profiler, &memo,
+                            placement[idx]);
+            }
+        }
+
+        if (release) {
+            // Sinks keep their inputs; those are the results
+            for (size_t member : chain) {
+                BaseNode* node = graphNodes[member].get();
+                if (node->outputs.empty()) continue;
+                for (auto& input : node->inputs) {
+                    input.data = cv::Mat();
+                    input.gpu = cv::UMat();
+                }
+            }
+            for (const InputLink& link : incoming[idx]) {
+                if (releasable[link.producer] &&
+                    readersLeft[link.producer].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    for (auto& output : graphNodes[link.producer]->outputs) {
+                        output.data = cv::Mat();
+                        output.gpu = cv::UMat();
+                        output.elided = true;
+                    }
+                }
+            }
+        }
+
+        for (size_t next : downstream[chain.back()]) {
+            if (pending[next].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                workers->submit([&run, next] { run(next); });
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(doneMutex);
+        if (--remaining == 0) done.notify_one();
+    };
+
+    // Seed the ready queue; independent branches are picked up by different workers
+    for (size_t idx : work) {
+        if (!chainMember[idx] && pending[idx].load(std::memory_order_relaxed) == 0) {
+            workers->submit([&run, idx] { run(idx); });
+        }
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(doneMutex);
+        done.wait(lock, [&remaining] { return remaining == 0; });
+    }
+    profiler.recordPass(passStart, NodeProfiler::Clock::now(), BufferPool::instance().stats().peak);
+
+    // Flags are only cleared once the whole pass is done so that propagation
+    // above always sees every change made since the previous pass
+    for (size_t idx : work) {
+        graphNodes[idx]->dirty = false;
+        if (processedIds) processedIds->push_back(graphNodes[idx]->id);
     }
 }
 
-//toposort logic
-void NodeEditor::processNode(BaseNode* node, std::unordered_set<BaseNode*>& processed) {
-    if (processed.count(node) > 0) {
-        return; // Skip if already processed
+// The memo key covers the parameters and the content of every input. An
+// input of unknown content (version 0) rules memoization out; so does an
+// empty input whose producer was elided, which only fused chains hand out.
+uint64_t NodeEditor::memoKey(BaseNode* node, const ResultCache* memo) {
+    if (!memo || !node->memoizable() || memo->budget() == 0) return 0;
+    uint64_t key = node->paramHash();
+    for (const auto& input : node->inputs) {
+        if (!input.data.empty() && input.version == 0) return 0;
+        key = ResultCache::combine(key, input.version);
     }
-    
-    // Process dependencies first
-    for (const auto& conn : connections) {
-        if (conn.inputNode == node->id) {
-            BaseNode* outputNode = findNodeById(conn.outputNode);
-            if (outputNode) {
-                processNode(outputNode, processed);
-                
-                // Find connected pins
-                int outputPinIdx = findPinIndex(outputNode->outputs, conn.outputPin);
-                int inputPinIdx = findPinIndex(node->inputs, conn.inputPin);
-                
-                if (outputPinIdx >= 0 && inputPinIdx >= 0) {
-    const cv::Mat& srcData = outputNode->outputs[outputPinIdx].data;
-    if (!srcData.empty()) {
-        // Always create a deep copy to avoid memory issues
-        node->inputs[inputPinIdx].data = srcData.clone();
+    return key;
+}
+
+// Frozen results are stored at full resolution, so the key leaves the
+// proxy scale out; proxy passes downscale the stored images instead
+uint64_t NodeEditor::frozenKey(BaseNode* node) {
+    const double scale = node->proxyScale;
+    node->proxyScale = 1.0;
+    const uint64_t key = node->paramHash();
+    node->proxyScale = scale;
+    return key;
+}
+
+// Outputs of a frozen node come straight from its mapped files; nothing
+// upstream is read
+void NodeEditor::restoreFrozen(BaseNode* node, NodeProfiler* profiler) {
+    const auto start = NodeProfiler::Clock::now();
+    std::vector<cv::Mat> mapped;
+    std::vector<uint64_t> contents;
+    if (!DiskCache::instance().load(node->id, node->outputs.size(), frozenKey(node), mapped, contents)) {
+        std::cerr << node->name << ": disk cache unreadable; unfreeze the node to recompute it" << std::endl;
+        mapped.assign(node->outputs.size(), cv::Mat());
+        contents.assign(node->outputs.size(), 0);
     }
+
+    size_t bytes = 0;
+    for (size_t o = 0; o < node->outputs.size(); ++o) {
+        Pin& output = node->outputs[o];
+        output.gpu = cv::UMat();
+        output.elided = false;
+        output.version = contents[o];
+        output.colorChannel = node->outputColorChannel(o);
+        output.views = std::make_shared<PinViews>();
+        if (node->proxyScale < 1.0 && !mapped[o].empty()) {
+            cv::resize(mapped[o], output.data, cv::Size(), node->proxyScale, node->proxyScale, cv::INTER_AREA);
+            uint64_t scaleBits = 0;
+            std::memcpy(&scaleBits, &node->proxyScale, sizeof(scaleBits));
+            output.version = ResultCache::combine(contents[o], scaleBits);
+        } else {
+            output.data = mapped[o];
+        }
+        bytes += output.data.total() * output.data.elemSize();
+    }
+    if (profiler) profiler->record(node->id, node->name, start, NodeProfiler::Clock::now(), bytes, 0, 0);
 }
+
+// Pulls the node's inputs from its producers and runs it, or restores its
+// outputs from the memo when it already ran with the same parameters and
+// inputs. Called from pool workers once every dirty producer has finished.
+void NodeEditor::processNode(BaseNode* node,
+                             const std::vector<InputLink>& links,
+                             const std::vector<std::unique_ptr<BaseNode>>& graphNodes,
+                             NodeProfiler* profiler,
+                             ResultCache* memo,
+                             Placement placement) {
+    // Inputs are fully determined by the current links; unlinked pins stay empty
+    for (auto& input : node->inputs) {
+        input.gpu = cv::UMat();
+        input.data = cv::Mat();
+        input.version = 0;
+        input.colorChannel = -1;
+        input.views.reset();
+    }
+    if (placement.fromDisk) {
+        restoreFrozen(node, profiler);
+        return;
+    }
+
+    // Pull fresh data from the connected output pins
+    for (const InputLink& link : links) {
+        const Pin& source = graphNodes[link.producer]->outputs[link.outputPin];
+        Pin& input = node->inputs[link.inputPin];
+        // A lone color channel is expanded once, for all consumers that need it
+        input.views = source.views;
+        const bool expand = source.colorChannel >= 0 && !node->readsChannelViews();
+        const cv::Mat host = expand ? source.color() : source.data;
+        input.colorChannel = expand ? -1 : source.colorChannel;
+        if (placement.gpu) {
+            // Stays on the device when the producer ran there; uploaded otherwise
+            input.data = host;
+            if (!source.gpu.empty()) {
+                input.gpu = source.gpu;
+            } else if (!host.empty()) {
+                host.copyTo(input.gpu);
             }
+        } else if (!host.empty()) {
+            // Share the upstream buffer; copy only for nodes that write into their inputs
+            input.data = node->mutatesInputs() ? host.clone() : host;
+        } else if (!source.gpu.empty()) {
+            // Kept on the device by a producer that did not expect a CPU consumer
+            source.gpu.copyTo(input.data);
         }
+        if (!input.data.empty() || !input.gpu.empty()) input.version = source.version;
+    }
+
+    const uint64_t key = memoKey(node, memo);
+
+    const ImageCache::Counters lookupsBefore = ImageCache::threadCounters();
+    const auto start = NodeProfiler::Clock::now();
+
+    std::vector<cv::Mat> results;
+    const bool restored = key != 0 && memo->lookup(node->id, key, results) &&
+                          results.size() == node->outputs.size();
+
+    // Kept until process() is done, so a buffer the node outputs again is recognized
+    std::vector<Pin> previous = node->outputs;
+
+    // Detach the previous outputs so the node allocates fresh buffers rather than
+    // overwriting data that downstream input pins may still be sharing
+    for (auto& output : node->outputs) {
+        output.data = cv::Mat();
+        output.gpu = cv::UMat();
+        output.elided = false;
+    }
+
+    bool succeeded = true;
+    if (restored) {
+        for (size_t o = 0; o < node->outputs.size(); ++o) {
+            node->outputs[o].data = results[o];
+        }
+    } else {
+        // Process current node; a failing node must not take down the worker thread
+        try {
+            if (placement.gpu) {
+                node->processGpu();
+                if (placement.hostOutputs) {
+                    for (auto& output : node->outputs) {
+                        if (output.data.empty() && !output.gpu.empty()) output.gpu.copyTo(output.data);
+                    }
+                }
+            } else {
+                node->process();
+            }
+        } catch (const std::exception& e) {
+            std::cerr << node->name << " failed: " << e.what() << std::endl;
+            succeeded = false;
+        }
+    }
+    const auto end = NodeProfiler::Clock::now();
+
+    for (size_t o = 0; o < node->outputs.size(); ++o) {
+        Pin& output = node->outputs[o];
+        output.colorChannel = node->outputColorChannel(o);
+        output.views = std::make_shared<PinViews>();
+        if (key != 0) {
+            output.version = ResultCache::combine(key, o);
+        } else if (!node->memoizable() && succeeded && !output.data.empty() && node->outputVersion(o) != 0) {
+            output.version = node->outputVersion(o);
+        } else if (!node->memoizable() && succeeded) {
+            // Not derived from a key: same buffer, same version; anything else is new
+            const Pin& before = previous[o];
+            bool same = !output.data.empty() && before.version != 0 &&
+                        output.data.data == before.data.data &&
+                        output.data.size() == before.data.size() &&
+                        output.data.type() == before.data.type();
+            output.version = same ? before.version : ResultCache::freshVersion();
+        } else {
+            output.version = 0;
+        }
+    }
+    // Results that only exist on the device are not memoized
+    const bool onHost = std::none_of(node->outputs.begin(), node->outputs.end(),
+        [](const Pin& output) { return output.data.empty() && !output.gpu.empty(); });
+    if (key != 0 && !restored && succeeded && onHost) {
+        results.clear();
+        for (const auto& output : node->outputs) results.push_back(output.data);
+        memo->store(node->id, key, results);
+    }
+    if (placement.toDisk && succeeded && onHost) {
+        results.clear();
+        for (const auto& output : node->outputs) results.push_back(output.data);
+        std::vector<uint64_t> contents;
+        if (DiskCache::instance().store(node->id, frozenKey(node), results, contents)) {
+            // Same versions as a later session that maps the files will see
+            for (size_t o = 0; o < node->outputs.size(); ++o) node->outputs[o].version = contents[o];
+        }
+    }
+
+    if (profiler) {
+        size_t bytes = 0;
+        for (const auto& output : node->outputs) {
+            bytes += output.data.empty() ? output.gpu.total() * output.gpu.elemSize()
+                                         : output.data.total() * output.data.elemSize();
+        }
+        const ImageCache::Counters lookupsAfter = ImageCache::threadCounters();
+        profiler->record(node->id, node->name, start, end, bytes,
+                         lookupsAfter.hits - lookupsBefore.hits,
+                         lookupsAfter.misses - lookupsBefore.misses);
     }
-    
-    // Process current node
-    node->process();
-    processed.insert(node);
 }
 
+// Runs a chain of pointwise nodes in one pass over the pixels. Their lookup
+// tables are composed, so 8-bit data is read once and written once (twice
+// when a member converts to gray). Only the last member's output is stored;
+// the others are marked elided. Other input types fall back to running the
+// members one by one.
+void NodeEditor::processChain(const std::vector<size_t>& chain,
+                              const Topology& graph,
+                              const std::vector<std::unique_ptr<BaseNode>>& graphNodes,
+                              NodeProfiler* profiler,
+                              ResultCache* memo) {
+    const Pin* source = nullptr;
+    for (const InputLink& link : graph.incoming[chain.front()]) {
+        source = &graphNodes[link.producer]->outputs[link.outputPin];
+    }
+
+    std::vector<cv::Mat> luts(chain.size());
+    std::vector<char> toGray(chain.size(), 0);
+    // A lone color channel is not the image its values describe, so it is not fused
+    bool fused = source && !source->data.empty() && source->colorChannel < 0 && source->data.depth() == CV_8U &&
+                 (source->data.channels() == 1 || source->data.channels() == 3);
+    int channels = fused ? source->data.channels() : 0;
+    for (size_t i = 0; fused && i < chain.size(); ++i) {
+        bool gray = false;
+        fused = graphNodes[chain[i]]->pointwiseLut(channels, luts[i], gray) &&
+                luts[i].type() == CV_8UC1 && luts[i].total() == 256;
+        toGray[i] = gray && channels == 3;
+        if (toGray[i]) channels = 1;
+    }
+    if (!fused) {
+        for (size_t idx : chain) {
+            processNode(graphNodes[idx].get(), graph.incoming[idx], graphNodes, profiler, memo, Placement());
+        }
+        return;
+    }
 
+    // Inputs and keys as if the members had run one after another
+    std::vector<uint64_t> keys(chain.size(), 0);
+    for (size_t i = 0; i < chain.size(); ++i) {
+        Pin& input = graphNodes[chain[i]]->inputs[0];
+        input.data = i == 0 ? source->data : cv::Mat();
+        input.version = i == 0 ? source->version : (keys[i - 1] ? ResultCache::combine(keys[i - 1], 0) : 0);
+        keys[i] = (i == 0 || keys[i - 1] != 0) ? memoKey(graphNodes[chain[i]].get(), memo) : 0;
+    }
+    BaseNode* last = graphNodes[chain.back()].get();
+    const uint64_t key = keys.back();
 
-template <NodeType T>
-void NodeEditor::addNode() {
-    auto node = createNode(T);
-    if (node) {
-        node->id = currentId++; // Assign unique node ID
+    // The source with the tables of the first `members` members applied in
+    // one pass; with every member that is the chain's result
+    auto applyFirst = [&](size_t members) {
+        cv::Mat current = source->data;
+        cv::Mat lut(1, 256, CV_8U);
+        unsigned char* table = lut.ptr<unsigned char>();
+        for (int v = 0; v < 256; v++) table[v] = static_cast<unsigned char>(v);
 
-        // Assign unique IDs to input pins
-        for (auto& input : node->inputs) {
-            input.id = currentId++;
+        for (size_t i = 0; i < members; ++i) {
+            if (toGray[i]) {
+                // Collapse to one channel with the tables composed so far applied
+                cv::Mat mapped, gray;
+                cv::LUT(current, lut, mapped);
+                cv::cvtColor(mapped, gray, cv::COLOR_BGR2GRAY);
+                current = gray;
+                for (int v = 0; v < 256; v++) table[v] = static_cast<unsigned char>(v);
+            }
+            const unsigned char* next = luts[i].ptr<unsigned char>();
+            for (int v = 0; v < 256; v++) table[v] = next[table[v]];
         }
+        cv::Mat applied;
+        cv::LUT(current, lut, applied);
+        return applied;
+    };
 
-        // Assign unique IDs to output pins
-        for (auto& output : node->outputs) {
-            output.id = currentId++;
+    const auto start = NodeProfiler::Clock::now();
+    std::vector<cv::Mat> results;
+    const bool restored = key != 0 && memo->lookup(last->id, key, results) && results.size() == 1;
+
+    cv::Mat result;
+    bool succeeded = true;
+    if (restored) {
+        result = results[0];
+    } else {
+        try {
+            result = applyFirst(chain.size());
+        } catch (const std::exception& e) {
+            std::cerr << last->name << " (fused) failed: " << e.what() << std::endl;
+            succeeded = false;
+        }
+    }
+    const auto end = NodeProfiler::Clock::now();
+
+    // Members the editor shows the input of get it produced after all; the
+    // first one already reads the source. Headless runs show nothing.
+    std::vector<cv::Mat> shown(chain.size());
+    if (succeeded && PreviewTexture::available()) {
+        for (size_t i = 1; i < chain.size(); ++i) {
+            if (!graphNodes[chain[i]]->showsInput()) continue;
+            try {
+                shown[i] = applyFirst(i);
+            } catch (const std::exception& e) {
+                std::cerr << graphNodes[chain[i]]->name << " (fused) input failed: " << e.what() << std::endl;
+            }
         }
+    }
+
+    for (size_t i = 0; i < chain.size(); ++i) {
+        BaseNode* node = graphNodes[chain[i]].get();
+        Pin& output = node->outputs[0];
+        const bool isLast = i + 1 == chain.size();
+        output.data = isLast && succeeded ? result : cv::Mat();
+        output.elided = !isLast;
+        output.colorChannel = -1;
+        output.views = std::make_shared<PinViews>();
+        output.version = succeeded && keys[i] ? ResultCache::combine(keys[i], 0) : 0;
+        if (i > 0) {
+            node->inputs[0].data = shown[i];
+            node->inputs[0].views = std::make_shared<PinViews>();
+        }
+    }
+    if (key != 0 && !restored && succeeded) {
+        memo->store(last->id, key, {result});
+    }
+
+    // The pass is attributed to the last member, which holds the result
+    if (profiler) {
+        profiler->record(last->id, last->name, start, end,
+                         result.total() * result.elemSize(), 0, 0);
+    }
+}
+
+void NodeEditor::setWorkerCount(unsigned count) {
+    // A pass already running keeps its own reference to the previous pool
+    std::atomic_store(&pool, std::make_shared<ThreadPool>(count));
+}
+
+unsigned NodeEditor::getWorkerCount() const {
+    return std::atomic_load(&pool)->workerCount();
+}
+
+bool NodeEditor::isGpuAvailable() {
+    return cv::ocl::haveOpenCL();
+}
+
+void NodeEditor::setGpuEnabled(bool enabled) {
+    // haveOpenCL() only says the runtime is there; useOpenCL() stays false
+    // unless a usable device is found. The workers apply the setting per pass.
+    enabled = enabled && isGpuAvailable();
+    cv::ocl::setUseOpenCL(enabled);
+    enabled = enabled && cv::ocl::useOpenCL();
+    useGpu.store(enabled, std::memory_order_relaxed);
+}
 
-        nodes.emplace_back(std::move(node));
+void NodeEditor::setWorkingDepth(int depth) {
+    if (depth != CV_16U && depth != CV_32F) depth = CV_8U;
+    if (depth == workingDepth) return;
+    workingDepth = depth;
+    // Part of every node's parameter hash, so memoized and frozen results
+    // made at the old depth are not reused
+    for (auto& node : nodes) {
+        node->workingDepth = depth;
+        node->dirty = true;
     }
 }
 
 
 
-BaseNode* NodeEditor::createNode(NodeType type) {
-    switch(type) {
-        case NodeType::ImageInput: return new ImageInputNode();
-        case NodeType::Output: return new OutputNode();
-        case NodeType::BrightnessContrast: return new BrightnessContrastNode();
-        case NodeType::ColorChannelSplitter: return new ColorChannelSplitterNode();
-        case NodeType::Blur: return new BlurNode();
-        case NodeType::Threshold: return new ThresholdNode();
-        case NodeType::EdgeDetection: return new EdgeDetectionNode();
-        case NodeType::Blend: return new BlendNode();
-        case NodeType::Noise: return new NoiseNode();
-        case NodeType::Convolution: return new ConvolutionNode();
-        default: return nullptr;
+BaseNode* NodeEditor::addNode(const std::string& typeName) {
+    BaseNode* node = createNode(typeName);
+    if (!node) return nullptr;
+
+    node->id = currentId++; // Assign unique node ID
+
+    // Assign unique IDs to input pins
+    for (auto& input : node->inputs) {
+        input.id = currentId++;
+    }
+
+    // Assign unique IDs to output pins
+    for (auto& output : node->outputs) {
+        output.id = currentId++;
     }
+
+    nodes.emplace_back(node);
+    indexNode(nodes.size() - 1);
+    invalidateTopology();
+    return node;
+}
+
+BaseNode* NodeEditor::createNode(const std::string& typeName) {
+    BaseNode* node = NodeRegistry::instance().create(typeName);
+    if (node) node->workingDepth = workingDepth;
+    return node;
 }
 
 
@@ -307,27 +1106,135 @@ void NodeEditor::drawProperties() {
         bool isHovered = ImNodes::IsLinkHovered(&hoveredLink);
         ImGui::Text("Link hovered: %d (Hovered: %s)", hoveredLink, isHovered ? "Yes" : "No");
 
+        // Decoded image cache
+        ImageCache& cache = ImageCache::instance();
+        int budgetMB = static_cast<int>(cache.budget() / (1024 * 1024));
+        ImGui::Text("Image cache: %.1f MB", cache.usage() / (1024.0 * 1024.0));
+        if (ImGui::SliderInt("Cache budget (MB)", &budgetMB, 64, 16384)) {
+            cache.setBudget(static_cast<size_t>(budgetMB) * 1024 * 1024);
+        }
+
+        // Graph evaluation workers (takes effect from the next pass)
+        int workers = static_cast<int>(getWorkerCount());
+        int maxWorkers = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        if (ImGui::SliderInt("Worker threads", &workers, 1, std::max(maxWorkers, workers))) {
+            setWorkerCount(static_cast<unsigned>(workers));
+        }
+        ImGui::Text("Evaluation: %s", isEvaluating() ? "running" : "idle");
+
         ImGui::End();
     }
 }
 
+void NodeEditor::drawProfiler() {
+    NodeProfiler::PassStats pass = profiler.lastPass();
+    ImGui::Text("Last evaluation: %.2f ms (%zu nodes, %.2f ms total node time), peak %.1f MB",
+                pass.wallMs, pass.nodes, pass.nodeMs, pass.peakBytes / (1024.0 * 1024.0));
+    BufferPool::Stats buffers = BufferPool::instance().stats();
+    ImGui::Text("Buffer pool: %.1f MB in use, %.1f MB idle, %llu reused, %llu allocated",
+                buffers.inUse / (1024.0 * 1024.0), buffers.idle / (1024.0 * 1024.0),
+                static_cast<unsigned long long>(buffers.reused),
+                static_cast<unsigned long long>(buffers.allocated));
+    ResultCache::Counters memoCounters = memo.counters();
+    ImGui::Text("Result cache: %.1f / %.0f MB, %llu hits, %llu misses",
+                memo.usage() / (1024.0 * 1024.0), memo.budget() / (1024.0 * 1024.0),
+                static_cast<unsigned long long>(memoCounters.hits),
+                static_cast<unsigned long long>(memoCounters.misses));
+
+    bool tracing = profiler.tracing();
+    if (ImGui::Checkbox("Record trace", &tracing)) {
+        profiler.setTracing(tracing);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Export trace...")) {
+        auto file = pfd::save_file("Export Chrome trace", "trace.json", {"Chrome Trace", "*.json"});
+        if (!file.result().empty()) profiler.exportTrace(file.result());
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Reset")) {
+        profiler.clear();
+    }
+    ImGui::SameLine();
+    ImGui::TextDisabled("%zu events", profiler.traceEventCount());
+
+    enum Column { ColName, ColCalls, ColLast, ColMean, ColP95, ColMemory, ColHits, ColMisses };
+    const ImGuiTableFlags flags = ImGuiTableFlags_Sortable | ImGuiTableFlags_Borders |
+                                  ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable |
+                                  ImGuiTableFlags_ScrollY;
+    if (!ImGui::BeginTable("profiler", 8, flags)) return;
+
+    ImGui::TableSetupColumn("Node", ImGuiTableColumnFlags_WidthStretch, 0.0f, ColName);
+    ImGui::TableSetupColumn("Calls", 0, 0.0f, ColCalls);
+    ImGui::TableSetupColumn("Last ms", ImGuiTableColumnFlags_PreferSortDescending, 0.0f, ColLast);
+    ImGui::TableSetupColumn("Mean ms", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending,
+                            0.0f, ColMean);
+    ImGui::TableSetupColumn("p95 ms", ImGuiTableColumnFlags_PreferSortDescending, 0.0f, ColP95);
+    ImGui::TableSetupColumn("Output MB", ImGuiTableColumnFlags_PreferSortDescending, 0.0f, ColMemory);
+    ImGui::TableSetupColumn("Cache hits", 0, 0.0f, ColHits);
+    ImGui::TableSetupColumn("Misses", 0, 0.0f, ColMisses);
+    ImGui::TableHeadersRow();
+
+    auto rows = profiler.snapshot();
+    if (ImGuiTableSortSpecs* sortSpecs = ImGui::TableGetSortSpecs()) {
+        if (sortSpecs->SpecsCount > 0) {
+            const ImGuiTableColumnSortSpecs& spec = sortSpecs->Specs[0];
+            const bool ascending = spec.SortDirection == ImGuiSortDirection_Ascending;
+            auto key = [&spec](const NodeProfiler::NodeStats& st) -> double {
+                switch (spec.ColumnUserID) {
+                    case ColCalls: return static_cast<double>(st.calls);
+                    case ColLast: return st.lastMs;
+                    case ColP95: return st.p95Ms;
+                    case ColMemory: return static_cast<double>(st.outputBytes);
+                    case ColHits: return static_cast<double>(st.cacheHits);
+                    case ColMisses: return static_cast<double>(st.cacheMisses);
+                    default: return st.meanMs;
+                }
+            };
+            std::sort(rows.begin(), rows.end(), [&](const auto& a, const auto& b) {
+                if (spec.ColumnUserID == ColName) {
+                    return ascending ? a.second.name < b.second.name : a.second.name > b.second.name;
+                }
+                return ascending ? key(a.second) < key(b.second) : key(a.second) > key(b.second);
+            });
+        }
+        sortSpecs->SpecsDirty = false;
+    }
+
+    for (const auto& row : rows) {
+        const NodeProfiler::NodeStats& st = row.second;
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn(); ImGui::Text("%s #%d", st.name.c_str(), row.first);
+        ImGui::TableNextColumn(); ImGui::Text("%llu", static_cast<unsigned long long>(st.calls));
+        ImGui::TableNextColumn(); ImGui::Text("%.2f", st.lastMs);
+        ImGui::TableNextColumn(); ImGui::Text("%.2f", st.meanMs);
+        ImGui::TableNextColumn(); ImGui::Text("%.2f", st.p95Ms);
+        ImGui::TableNextColumn(); ImGui::Text("%.1f", st.outputBytes / (1024.0 * 1024.0));
+        ImGui::TableNextColumn(); ImGui::Text("%llu", static_cast<unsigned long long>(st.cacheHits));
+        ImGui::TableNextColumn(); ImGui::Text("%llu", static_cast<unsigned long long>(st.cacheMisses));
+    }
+    ImGui::EndTable();
+}
+
 
 
 void NodeEditor::clear() {
+    // Node ids restart from zero, so results still in flight must never be swapped in
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        if (runningJob) runningJob->cancelled = true;
+        pendingJob.reset();
+        completedJob.reset();
+    }
+    ++latestGeneration;
+    unresolvedDirty.clear();
+
     nodes.clear();
     connections.clear();
+    nodeIndex.clear();
+    pinIndex.clear();
+    invalidateTopology();
+    profiler.clear();
+    memo.clear();
     currentId = 0;
     selectedNode = nullptr;
 }
-
-// Add at the end of NodeEditor.cpp
-template void NodeEditor::addNode<NodeType::ImageInput>();
-template void NodeEditor::addNode<NodeType::Output>();
-template void NodeEditor::addNode<NodeType::BrightnessContrast>();
-template void NodeEditor::addNode<NodeType::ColorChannelSplitter>();
-template void NodeEditor::addNode<NodeType::Blur>();
-template void NodeEditor::addNode<NodeType::Threshold>();
-template void NodeEditor::addNode<NodeType::EdgeDetection>();
-template void NodeEditor::addNode<NodeType::Blend>();
-template void NodeEditor::addNode<NodeType::Noise>();
-template void NodeEditor::addNode<NodeType::Convolution>();
\ No newline at end of file
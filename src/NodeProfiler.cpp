@@ -0,0 +1,157 @@
+// NodeProfiler.cpp
+// Per-node timing/memory statistics and Chrome trace export
+#include "NodeProfiler.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+double toMs(NodeProfiler::Clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+void writeJsonString(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') out << '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) out << c;
+    }
+    out << '"';
+}
+
+} // namespace
+
+void NodeProfiler::record(int nodeId, const std::string& name, Clock::time_point start,
+                          Clock::time_point end, size_t outputBytes,
+                          uint64_t cacheHits, uint64_t cacheMisses) {
+    const double ms = toMs(end - start);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Series& s = series[nodeId];
+    NodeStats& st = s.stats;
+    st.name = name;
+    st.calls++;
+    st.lastMs = ms;
+    st.meanMs += (ms - st.meanMs) / static_cast<double>(st.calls);
+    st.outputBytes = outputBytes;
+    st.cacheHits += cacheHits;
+    st.cacheMisses += cacheMisses;
+
+    s.samples[s.next % kWindow] = static_cast<float>(ms);
+    s.next++;
+    size_t n = std::min(s.next, kWindow);
+    std::array<float, kWindow> sorted = s.samples;
+    size_t rank = (n * 95 + 99) / 100 - 1;
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.begin() + n);
+    st.p95Ms = sorted[rank];
+
+    running.nodeMs += ms;
+    running.nodes++;
+
+    if (tracing()) {
+        if (events.size() >= kMaxEvents) events.pop_front();
+        events.push_back({name, nodeId,
+                          std::chrono::duration_cast<std::chrono::microseconds>(start - epoch).count(),
+                          std::chrono::duration_cast<std::chrono::microseconds>(end - start).count(),
+                          threadNumberLocked(std::this_thread::get_id())});
+    }
+}
+
+void NodeProfiler::recordPass(Clock::time_point start, Clock::time_point end, size_t peakBytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    pass = running;
+    pass.wallMs = toMs(end - start);
+    pass.peakBytes = peakBytes;
+    running = PassStats();
+
+    if (tracing()) {
+        if (events.size() >= kMaxEvents) events.pop_front();
+        events.push_back({"Evaluate graph", -1,
+                          std::chrono::duration_cast<std::chrono::microseconds>(start - epoch).count(),
+                          std::chrono::duration_cast<std::chrono::microseconds>(end - start).count(),
+                          threadNumberLocked(std::this_thread::get_id())});
+    }
+}
+
+bool NodeProfiler::stats(int nodeId, NodeStats& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = series.find(nodeId);
+    if (it == series.end()) return false;
+    out = it->second.stats;
+    return true;
+}
+
+std::vector<std::pair<int, NodeProfiler::NodeStats>> NodeProfiler::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::pair<int, NodeStats>> result;
+    result.reserve(series.size());
+    for (const auto& entry : series) {
+        result.emplace_back(entry.first, entry.second.stats);
+    }
+    return result;
+}
+
+NodeProfiler::PassStats NodeProfiler::lastPass() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pass;
+}
+
+void NodeProfiler::forget(int nodeId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    series.erase(nodeId);
+}
+
+void NodeProfiler::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    series.clear();
+    pass = PassStats();
+    running = PassStats();
+    events.clear();
+}
+
+void NodeProfiler::setTracing(bool enabled) {
+    tracingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+size_t NodeProfiler::traceEventCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return events.size();
+}
+
+int NodeProfiler::threadNumberLocked(std::thread::id thread) {
+    auto it = threadNumbers.find(thread);
+    if (it != threadNumbers.end()) return it->second;
+    int number = static_cast<int>(threadNumbers.size()) + 1;
+    threadNumbers.emplace(thread, number);
+    return number;
+}
+
+bool NodeProfiler::exportTrace(const std::string& path) const {
+    std::deque<TraceEvent> copy;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        copy = events;
+    }
+
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Cannot write trace: " << path << std::endl;
+        return false;
+    }
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (const auto& event : copy) {
+        if (!first) out << ",";
+        first = false;
+        out << "\n{\"name\":";
+        writeJsonString(out, event.name);
+        out << ",\"cat\":\"" << (event.nodeId < 0 ? "graph" : "node") << "\""
+            << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+            << ",\"ts\":" << event.startUs << ",\"dur\":" << event.durationUs
+            << ",\"args\":{\"id\":" << event.nodeId << "}}";
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
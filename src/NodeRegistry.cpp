@@ -0,0 +1,174 @@
+// NodeRegistry.cpp
+// Built-in node types and plugin loading
+#include "NodeRegistry.hpp"
+#include "nodes/ImageInputNode.hpp"
+#include "nodes/OutputNode.hpp"
+#include "nodes/BrightnessContrastNode.hpp"
+#include "nodes/ColorChannelSplitterNode.hpp"
+#include "nodes/BlurNode.hpp"
+#include "nodes/ThresholdNode.hpp"
+#include "nodes/EdgeDetectionNode.hpp"
+#include "nodes/BlendNode.hpp"
+#include "nodes/NoiseNode.hpp"
+#include "nodes/ConvolutionNode.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using VersionFunction = int (*)();
+using RegisterFunction = void (*)(NodeRegistry&);
+
+#ifdef _WIN32
+constexpr char kPathSeparator = ';';
+#else
+constexpr char kPathSeparator = ':';
+#endif
+
+bool isLibrary(const fs::path& path) {
+    const std::string ext = path.extension().string();
+    return ext == ".so" || ext == ".dylib" || ext == ".dll";
+}
+
+} // namespace
+
+NodeRegistry& NodeRegistry::instance() {
+    static NodeRegistry registry;
+    return registry;
+}
+
+NodeRegistry::NodeRegistry() {
+    add<ImageInputNode>("Image Input");
+    add<OutputNode>("Output");
+    add<BrightnessContrastNode>("Brightness/Contrast");
+    add<ColorChannelSplitterNode>("Channel Splitter");
+    add<BlurNode>("Blur");
+    add<ThresholdNode>("Threshold");
+    add<EdgeDetectionNode>("Edge Detection");
+    add<BlendNode>("Blend");
+    add<NoiseNode>("Noise");
+    add<ConvolutionNode>("Convolution");
+}
+
+bool NodeRegistry::add(const std::string& label, Factory create) {
+    // The type is known by the name its nodes carry, which is what graph
+    // files store, so one node is made to read it
+    std::unique_ptr<BaseNode> probe(create ? create() : nullptr);
+    const std::string origin = loadingOrigin.empty() ? "built-in" : loadingOrigin;
+    if (!probe) {
+        std::cerr << "Node type '" << label << "' (" << origin << ") creates no node" << std::endl;
+        return false;
+    }
+    if (const Entry* existing = find(probe->name)) {
+        std::cerr << "Node type '" << probe->name << "' (" << origin << ") is already registered by "
+                  << (existing->origin.empty() ? "built-in" : existing->origin) << std::endl;
+        return false;
+    }
+    types.push_back({probe->name, label, std::move(create), loadingOrigin});
+    return true;
+}
+
+const NodeRegistry::Entry* NodeRegistry::find(const std::string& name) const {
+    auto it = std::find_if(types.begin(), types.end(), [&name](const Entry& entry) { return entry.name == name; });
+    return it != types.end() ? &*it : nullptr;
+}
+
+BaseNode* NodeRegistry::create(const std::string& name) const {
+    const Entry* entry = find(name);
+    return entry ? entry->create() : nullptr;
+}
+
+bool NodeRegistry::loadPlugin(const std::string& path) {
+    std::error_code ec;
+    if (!fs::is_directory(path, ec)) return loadLibrary(path);
+
+    // Sorted, so types register in the same order on every run
+    std::vector<fs::path> libraries;
+    for (const auto& entry : fs::directory_iterator(path, ec)) {
+        if (entry.is_regular_file(ec) && isLibrary(entry.path())) libraries.push_back(entry.path());
+    }
+    std::sort(libraries.begin(), libraries.end());
+    bool ok = true;
+    for (const auto& library : libraries) ok = loadLibrary(library.string()) && ok;
+    return ok;
+}
+
+int NodeRegistry::loadPlugins(const std::string& searchPath) {
+    int loaded = 0;
+    size_t start = 0;
+    while (start <= searchPath.size()) {
+        size_t end = searchPath.find(kPathSeparator, start);
+        if (end == std::string::npos) end = searchPath.size();
+        const std::string entry = searchPath.substr(start, end - start);
+        if (!entry.empty()) {
+            const size_t before = types.size();
+            loadPlugin(entry);
+            if (types.size() > before) ++loaded;
+        }
+        start = end + 1;
+    }
+    return loaded;
+}
+
+std::string NodeRegistry::defaultSearchPath() {
+    const char* path = std::getenv("NODEIMG_PLUGIN_PATH");
+    return path ? path : "";
+}
+
+bool NodeRegistry::loadLibrary(const std::string& path) {
+#ifdef _WIN32
+    HMODULE library = LoadLibraryA(path.c_str());
+    if (!library) {
+        std::cerr << "Cannot load plugin " << path << " (error " << GetLastError() << ")" << std::endl;
+        return false;
+    }
+    auto version = reinterpret_cast<VersionFunction>(GetProcAddress(library, "nodeimg_plugin_api_version"));
+    auto registerNodes = reinterpret_cast<RegisterFunction>(GetProcAddress(library, "nodeimg_register_nodes"));
+#else
+    // Local: plugins do not see each other's symbols, only the host's
+    void* library = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!library) {
+        std::cerr << "Cannot load plugin " << path << ": " << dlerror() << std::endl;
+        return false;
+    }
+    auto version = reinterpret_cast<VersionFunction>(dlsym(library, "nodeimg_plugin_api_version"));
+    auto registerNodes = reinterpret_cast<RegisterFunction>(dlsym(library, "nodeimg_register_nodes"));
+#endif
+    // A library that is not a plugin, or one built for another API, is left
+    // loaded but unused; its static destructors may not be safe to run
+    if (!version || !registerNodes) {
+        std::cerr << path << " is not a node plugin" << std::endl;
+        return false;
+    }
+    if (version() != kApiVersion) {
+        std::cerr << "Plugin " << path << " was built for node API " << version()
+                  << ", this build provides " << kApiVersion << std::endl;
+        return false;
+    }
+
+    const size_t before = types.size();
+    loadingOrigin = path;
+    try {
+        registerNodes(*this);
+    } catch (const std::exception& e) {
+        std::cerr << "Plugin " << path << " failed to register: " << e.what() << std::endl;
+    }
+    loadingOrigin.clear();
+    if (types.size() == before) {
+        std::cerr << "Plugin " << path << " registered no node types" << std::endl;
+        return false;
+    }
+    std::cerr << "Loaded " << (types.size() - before) << " node type(s) from " << path << std::endl;
+    return true;
+}
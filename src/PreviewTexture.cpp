@@ -0,0 +1,22 @@
+// PreviewTexture.cpp
+// Registry for the preview texture implementation supplied by the GUI
+#include "PreviewTexture.hpp"
+
+namespace {
+    PreviewTexture::Factory& registeredFactory() {
+        static PreviewTexture::Factory factory;
+        return factory;
+    }
+}
+
+void PreviewTexture::setFactory(Factory factory) {
+    registeredFactory() = std::move(factory);
+}
+
+bool PreviewTexture::available() {
+    return static_cast<bool>(registeredFactory());
+}
+
+std::unique_ptr<PreviewTexture> PreviewTexture::create() {
+    return available() ? registeredFactory()() : nullptr;
+}
@@ -0,0 +1,116 @@
+// ResultCache.cpp
+// Memory-bounded LRU of node outputs keyed by parameter and input hashes
+#include "ResultCache.hpp"
+
+std::atomic<uint64_t> ResultCache::versionCounter{0};
+
+uint64_t ResultCache::combine(uint64_t seed, uint64_t value) {
+    // splitmix64 finalizer over the pair; order-sensitive
+    uint64_t h = seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebull;
+    h ^= h >> 31;
+    return h;
+}
+
+uint64_t ResultCache::freshVersion() {
+    // Mixed so fresh versions do not collide with small hash values
+    return combine(0x6a09e667f3bcc909ull, ++versionCounter);
+}
+
+uint64_t ResultCache::slot(int nodeId, uint64_t key) {
+    return combine(key, static_cast<uint64_t>(static_cast<uint32_t>(nodeId)));
+}
+
+bool ResultCache::lookup(int nodeId, uint64_t key, std::vector<cv::Mat>& outputs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(slot(nodeId, key));
+    if (it == index.end() || it->second->nodeId != nodeId || it->second->key != key) {
+        ++stats.misses;
+        return false;
+    }
+    lru.splice(lru.begin(), lru, it->second);
+    outputs = it->second->outputs;
+    ++stats.hits;
+    return true;
+}
+
+void ResultCache::store(int nodeId, uint64_t key, const std::vector<cv::Mat>& outputs) {
+    Entry entry;
+    entry.nodeId = nodeId;
+    entry.key = key;
+    entry.outputs = outputs;
+    for (const cv::Mat& m : outputs) {
+        entry.bytes += m.total() * m.elemSize();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (entry.bytes > budgetBytes) return;
+
+    const uint64_t s = slot(nodeId, key);
+    auto it = index.find(s);
+    if (it != index.end()) {
+        // Computed concurrently by an overlapping evaluation; keep one copy
+        usedBytes -= it->second->bytes;
+        lru.erase(it->second);
+        index.erase(it);
+    }
+
+    usedBytes += entry.bytes;
+    lru.push_front(std::move(entry));
+    index[s] = lru.begin();
+    evictLocked();
+}
+
+void ResultCache::evictLocked() {
+    while (usedBytes > budgetBytes && !lru.empty()) {
+        const Entry& victim = lru.back();
+        usedBytes -= victim.bytes;
+        index.erase(slot(victim.nodeId, victim.key));
+        lru.pop_back();
+    }
+}
+
+void ResultCache::forget(int nodeId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = lru.begin(); it != lru.end();) {
+        if (it->nodeId == nodeId) {
+            usedBytes -= it->bytes;
+            index.erase(slot(it->nodeId, it->key));
+            it = lru.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ResultCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    lru.clear();
+    index.clear();
+    usedBytes = 0;
+    stats = Counters();
+}
+
+void ResultCache::setBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    budgetBytes = bytes;
+    evictLocked();
+}
+
+size_t ResultCache::budget() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return budgetBytes;
+}
+
+size_t ResultCache::usage() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return usedBytes;
+}
+
+ResultCache::Counters ResultCache::counters() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
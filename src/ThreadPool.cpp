@@ -0,0 +1,99 @@
+// ThreadPool.cpp
+// Work-stealing pool used by NodeEditor to evaluate independent graph branches concurrently
+#include "ThreadPool.hpp"
+#include <algorithm>
+
+namespace {
+    // Identifies the pool and queue of the current worker thread, if any
+    thread_local const ThreadPool* currentPool = nullptr;
+    thread_local unsigned currentIndex = 0;
+}
+
+ThreadPool::ThreadPool(unsigned workerCount) {
+    if (workerCount == 0) {
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned i = 0; i < workerCount; ++i) {
+        queues.emplace_back(std::make_unique<WorkQueue>());
+    }
+    for (unsigned i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(Task task) {
+    // Keep follow-up work local to the submitting worker; spread external submissions
+    unsigned index = (currentPool == this)
+        ? currentIndex
+        : nextQueue.fetch_add(1, std::memory_order_relaxed) % workerCount();
+
+    // Counted before it is published: a worker may take the task and
+    // decrement the count as soon as it is in a queue
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queued.fetch_add(1, std::memory_order_release);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+bool ThreadPool::tryPop(unsigned index, Task& task) {
+    WorkQueue& queue = *queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::trySteal(unsigned thief, Task& task) {
+    const unsigned count = workerCount();
+    for (unsigned offset = 1; offset < count; ++offset) {
+        WorkQueue& victim = *queues[(thief + offset) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(unsigned index) {
+    currentPool = this;
+    currentIndex = index;
+
+    while (true) {
+        Task task;
+        if (tryPop(index, task) || trySteal(index, task)) {
+            queued.fetch_sub(1, std::memory_order_acq_rel);
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] {
+            return stopping.load() || queued.load(std::memory_order_acquire) > 0;
+        });
+        if (stopping && queued.load() == 0) {
+            return;
+        }
+    }
+}
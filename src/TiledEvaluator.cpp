@@ -0,0 +1,323 @@
+// TiledEvaluator.cpp
+// Tile-by-tile graph evaluation with per-node halos, for images larger than memory allows
+#include "TiledEvaluator.hpp"
+#include "BufferPool.hpp"
+#include "DiskCache.hpp"
+#include "NodeEditor.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <climits>
+#include <condition_variable>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+cv::Rect TiledEvaluator::grow(const cv::Rect& region, int halo, const cv::Size& bounds) {
+    cv::Rect grown(region.x - halo, region.y - halo, region.width + 2 * halo, region.height + 2 * halo);
+    return grown & cv::Rect(0, 0, bounds.width, bounds.height);
+}
+
+cv::Rect TiledEvaluator::merge(const cv::Rect& a, const cv::Rect& b) {
+    if (a.empty()) return b;
+    if (b.empty()) return a;
+    return a | b;
+}
+
+void TiledEvaluator::run(NodeEditor& editor, int tileSize) {
+    editor.pruneConnections();
+    editor.useFullResolution();
+    std::shared_ptr<const NodeEditor::Topology> graph = editor.currentTopology();
+    auto& nodes = editor.nodes;
+    const auto& incoming = graph->incoming;
+    const auto& outgoing = graph->outgoing;
+    const size_t count = nodes.size();
+    if (count == 0) return;
+
+    tileSize = std::max(tileSize, 16);
+    std::shared_ptr<ThreadPool> workers = std::atomic_load(&editor.pool);
+
+    BufferPool::instance().resetPeak();
+    const auto passStart = NodeProfiler::Clock::now();
+    std::vector<char> done(count, 0);       // Outputs are available as whole images
+    std::vector<char> forcedFull(count, 0); // Tileable, but its inputs disagree in size
+
+    // Frozen nodes behave as in untiled passes: valid files stand in for
+    // everything upstream, and a frozen node without them runs whole so
+    // its results can be written
+    std::vector<char> fromDisk(count, 0);
+    for (size_t idx : graph->order) {
+        BaseNode* node = nodes[idx].get();
+        if (!node->frozen) continue;
+        fromDisk[idx] = DiskCache::instance().has(node->id, node->outputs.size(), NodeEditor::frozenKey(node));
+        if (fromDisk[idx]) {
+            NodeEditor::Placement placement;
+            placement.fromDisk = true;
+            NodeEditor::processNode(node, incoming[idx], nodes, &editor.profiler, &editor.memo, placement);
+            done[idx] = 1;
+        } else {
+            forcedFull[idx] = 1;
+        }
+    }
+    // Nodes that only feed frozen nodes with valid files are not run
+    std::vector<char> needed(count, 0);
+    for (auto it = graph->order.rbegin(); it != graph->order.rend(); ++it) {
+        const size_t idx = *it;
+        needed[idx] = !fromDisk[idx] && (outgoing[idx].empty() ||
+            std::any_of(outgoing[idx].begin(), outgoing[idx].end(), [&needed](size_t c) { return needed[c]; }));
+        if (!needed[idx] && !done[idx]) {
+            for (auto& output : nodes[idx]->outputs) {
+                output.data = cv::Mat();
+                output.gpu = cv::UMat();
+                output.elided = true;
+            }
+            done[idx] = 1;
+        }
+    }
+
+    // Each iteration plans the remaining nodes into passes, then runs the
+    // lowest one: its untiled nodes first, then its tiled nodes tile by tile.
+    // A node in pass k that is untiled but reads a tiled node sits in pass k+1,
+    // so that tiled node's output is assembled before it is needed.
+    for (;;) {
+        std::vector<char> tiled(count, 0);
+        std::vector<int> pass(count, 0);
+        int current = INT_MAX;
+        for (size_t idx : graph->order) {
+            if (done[idx]) continue;
+            tiled[idx] = !forcedFull[idx] && !incoming[idx].empty() && nodes[idx]->tileHalo() >= 0;
+            for (const auto& link : incoming[idx]) {
+                size_t q = link.producer;
+                pass[idx] = std::max(pass[idx], pass[q] + (tiled[q] && !tiled[idx] ? 1 : 0));
+            }
+            current = std::min(current, pass[idx]);
+        }
+        if (current == INT_MAX) break;
+
+        for (size_t idx : graph->order) {
+            if (!done[idx] && !tiled[idx] && pass[idx] == current) {
+                NodeEditor::Placement placement;
+                placement.toDisk = nodes[idx]->frozen; // Only frozen nodes without valid files get here
+                NodeEditor::processNode(nodes[idx].get(), incoming[idx], nodes, &editor.profiler, &editor.memo,
+                                        placement);
+                done[idx] = 1;
+            }
+        }
+
+        // Tiled nodes all have to agree with their producers on the image size
+        std::vector<size_t> group;
+        std::vector<cv::Size> size(count);
+        bool replan = false;
+        for (size_t idx : graph->order) {
+            if (done[idx] || !tiled[idx] || pass[idx] != current) continue;
+            cv::Size common;
+            bool mismatch = false;
+            for (const auto& link : incoming[idx]) {
+                size_t q = link.producer;
+                cv::Size produced = done[q] ? nodes[q]->outputs[link.outputPin].data.size() : size[q];
+                if (produced.empty() || (!common.empty() && produced != common)) {
+                    mismatch = true;
+                }
+                if (common.empty()) common = produced;
+            }
+            if (mismatch) {
+                forcedFull[idx] = 1;
+                replan = true;
+            }
+            size[idx] = common;
+            group.push_back(idx);
+        }
+        if (replan || group.empty()) continue;
+
+        std::vector<int> position(count, -1);
+        for (size_t i = 0; i < group.size(); ++i) position[group[i]] = static_cast<int>(i);
+
+        // Outputs leaving the pass are assembled into whole images. Those read
+        // by a node that wants their statistics get them gathered per tile,
+        // while each tile is still in cache, instead of in another pass.
+        std::vector<char> materialize(group.size(), 0);
+        std::vector<char> gatherStats(group.size(), 0);
+        std::vector<int> halo(group.size());
+        for (size_t i = 0; i < group.size(); ++i) {
+            const auto& consumers = outgoing[group[i]];
+            materialize[i] = consumers.empty() ||
+                std::any_of(consumers.begin(), consumers.end(),
+                            [&position](size_t c) { return position[c] < 0; });
+            gatherStats[i] = std::any_of(consumers.begin(), consumers.end(),
+                [&](size_t c) { return position[c] < 0 && nodes[c]->readsInputStats(); });
+            halo[i] = nodes[group[i]]->tileHalo();
+        }
+
+        // Independent tiled chains may run at different image sizes
+        std::map<std::pair<int, int>, std::vector<size_t>> bySize;
+        for (size_t i = 0; i < group.size(); ++i) {
+            const cv::Size& s = size[group[i]];
+            bySize[{s.width, s.height}].push_back(i);
+        }
+
+        std::vector<std::vector<cv::Mat>> assembled(group.size());
+        std::vector<std::vector<ImageStats>> gathered(group.size());
+        for (size_t i = 0; i < group.size(); ++i) {
+            assembled[i].resize(nodes[group[i]]->outputs.size());
+            gathered[i].resize(nodes[group[i]]->outputs.size());
+        }
+        std::mutex assembleMutex;
+
+        std::mutex doneMutex;
+        std::condition_variable allDone;
+        size_t remaining = 0;
+
+        for (const auto& entry : bySize) {
+            const cv::Size bounds(entry.first.first, entry.first.second);
+            const std::vector<size_t>& members = entry.second; // Positions in group, topological order
+
+            auto runTile = [&, bounds](cv::Rect tile) {
+                std::vector<cv::Rect> need(group.size());
+                std::vector<std::vector<cv::Mat>> tileOut(group.size());
+                std::vector<std::unique_ptr<BaseNode>> local(group.size());
+
+                // Back to front: a node must cover what its consumers read, halos included
+                for (auto it = members.rbegin(); it != members.rend(); ++it) {
+                    size_t i = *it;
+                    cv::Rect region = materialize[i] ? tile : cv::Rect();
+                    for (size_t c : outgoing[group[i]]) {
+                        int pc = position[c];
+                        if (pc >= 0 && !need[pc].empty()) {
+                            region = merge(region, grow(need[pc], halo[pc], bounds));
+                        }
+                    }
+                    need[i] = region;
+                }
+
+                for (size_t i : members) {
+                    if (need[i].empty()) continue;
+                    const size_t idx = group[i];
+                    local[i].reset(nodes[idx]->clone());
+                    BaseNode* node = local[i].get();
+                    const cv::Rect inRect = grow(need[i], halo[i], bounds);
+
+                    // Compact copies of just the region this tile reads
+                    for (auto& input : node->inputs) {
+                        input.data = cv::Mat();
+                        input.colorChannel = -1;
+                        input.views.reset();
+                    }
+                    for (const auto& link : incoming[idx]) {
+                        int pq = position[link.producer];
+                        const cv::Mat& src = pq >= 0 ? tileOut[pq][link.outputPin]
+                                                     : nodes[link.producer]->outputs[link.outputPin].data;
+                        cv::Point origin = pq >= 0 ? need[pq].tl() : cv::Point(0, 0);
+                        if (src.empty()) continue;
+                        Pin& input = node->inputs[link.inputPin];
+                        src(cv::Rect(inRect.tl() - origin, inRect.size())).copyTo(input.data);
+                        // Formats follow from parameters, which tile clones share
+                        const int channel = nodes[link.producer]->outputColorChannel(link.outputPin);
+                        if (channel >= 0 && !node->readsChannelViews()) {
+                            input.data = Pin::expandChannel(input.data, channel);
+                        } else {
+                            input.colorChannel = channel;
+                        }
+                    }
+                    for (auto& output : node->outputs) output.data = cv::Mat();
+
+                    const auto start = NodeProfiler::Clock::now();
+                    try {
+                        node->process();
+                    } catch (const std::exception& e) {
+                        std::cerr << node->name << " failed on tile: " << e.what() << std::endl;
+                    }
+                    size_t bytes = 0;
+                    for (const auto& output : node->outputs) {
+                        bytes += output.data.total() * output.data.elemSize();
+                    }
+                    editor.profiler.record(node->id, node->name, start, NodeProfiler::Clock::now(),
+                                           bytes, 0, 0);
+
+                    // Drop the halo again; it only served as context
+                    tileOut[i].resize(node->outputs.size());
+                    const cv::Rect inner(need[i].tl() - inRect.tl(), need[i].size());
+                    for (size_t o = 0; o < node->outputs.size(); ++o) {
+                        const cv::Mat& out = node->outputs[o].data;
+                        if (out.empty()) continue;
+                        if (out.size() != inRect.size()) {
+                            std::cerr << node->name << " changed the tile size; output dropped" << std::endl;
+                            continue;
+                        }
+                        tileOut[i][o] = out(inner);
+                    }
+
+                    if (materialize[i]) {
+                        const cv::Rect part(tile.tl() - need[i].tl(), tile.size());
+                        for (size_t o = 0; o < tileOut[i].size(); ++o) {
+                            if (tileOut[i][o].empty()) continue;
+                            cv::Mat target;
+                            {
+                                std::lock_guard<std::mutex> lock(assembleMutex);
+                                if (assembled[i][o].empty()) {
+                                    assembled[i][o].create(bounds, tileOut[i][o].type());
+                                }
+                                target = assembled[i][o];
+                            }
+                            if (target.type() != tileOut[i][o].type()) continue;
+                            tileOut[i][o](part).copyTo(target(tile));
+                            if (gatherStats[i]) {
+                                Pin piece{0, ""};
+                                piece.data = tileOut[i][o](part);
+                                piece.colorChannel = node->outputColorChannel(o);
+                                const ImageStats partial = ImageStats::of(piece.gray());
+                                std::lock_guard<std::mutex> lock(assembleMutex);
+                                gathered[i][o].merge(partial);
+                            }
+                        }
+                    }
+
+                    // Inputs are no longer needed by anyone
+                    for (auto& input : node->inputs) input.data = cv::Mat();
+                }
+
+                std::lock_guard<std::mutex> lock(doneMutex);
+                if (--remaining == 0) allDone.notify_one();
+            };
+
+            for (int y = 0; y < bounds.height; y += tileSize) {
+                for (int x = 0; x < bounds.width; x += tileSize) {
+                    cv::Rect tile(x, y, std::min(tileSize, bounds.width - x),
+                                  std::min(tileSize, bounds.height - y));
+                    {
+                        std::lock_guard<std::mutex> lock(doneMutex);
+                        ++remaining;
+                    }
+                    workers->submit([runTile, tile] { runTile(tile); });
+                }
+            }
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(doneMutex);
+            allDone.wait(lock, [&remaining] { return remaining == 0; });
+        }
+
+        for (size_t i = 0; i < group.size(); ++i) {
+            BaseNode* node = nodes[group[i]].get();
+            for (auto& input : node->inputs) input.data = cv::Mat();
+            for (size_t o = 0; o < node->outputs.size(); ++o) {
+                node->outputs[o].data = assembled[i][o];
+                node->outputs[o].version = 0; // Assembled from tiles, never memoized
+                node->outputs[o].colorChannel = node->outputColorChannel(o);
+                node->outputs[o].views = std::make_shared<PinViews>();
+                if (gatherStats[i] && !assembled[i][o].empty()) {
+                    node->outputs[o].views->source = assembled[i][o];
+                    node->outputs[o].views->stats = std::make_shared<const ImageStats>(gathered[i][o]);
+                }
+                node->outputs[o].elided = !materialize[i];
+            }
+            done[group[i]] = 1;
+        }
+    }
+
+    for (auto& node : nodes) {
+        node->dirty = false;
+    }
+    editor.profiler.recordPass(passStart, NodeProfiler::Clock::now(), BufferPool::instance().stats().peak);
+}
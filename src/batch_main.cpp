@@ -0,0 +1,250 @@
+// batch_main.cpp
+// Headless runner: streams a list of images through a saved graph without any
+// window or GL context. Decoding, graph evaluation and encoding run on
+// separate threads so consecutive images overlap in the pipeline.
+#include "BoundedQueue.hpp"
+#include "BufferPool.hpp"
+#include "GraphSerializer.hpp"
+#include "ImageEncoder.hpp"
+#include "NodeEditor.hpp"
+#include "NodeRegistry.hpp"
+#include "nodes/ImageInputNode.hpp"
+#include "nodes/OutputNode.hpp"
+#include <opencv2/imgcodecs.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Options {
+    std::string graphPath;
+    std::string outputDir = ".";
+    int inputNodeId = -1;   // -1 = first Image Input node in the graph
+    unsigned workers = 0;   // 0 = all cores
+    unsigned encoders = 2;
+    int tileSize = 0;       // 0 = evaluate whole images
+    std::string tracePath;  // Chrome trace of every node call, if set
+    bool gpu = false;
+    int depth = -1;         // Working depth (CV_8U, CV_16U, CV_32F); -1 = the graph's own
+    std::vector<std::string> plugins; // Loaded after $NODEIMG_PLUGIN_PATH
+    std::vector<std::string> inputs;
+};
+
+struct DecodedImage {
+    fs::path source;
+    cv::Mat image;
+};
+
+void printUsage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " --graph <graph.nig|graph.json> [options] <image|directory>...\n"
+              << "Options:\n"
+              << "  --output <dir>      Directory for results (default: current directory)\n"
+              << "  --input-node <id>   Image Input node fed with each image (default: first one)\n"
+              << "  --workers <n>       Threads evaluating the graph (default: all cores)\n"
+              << "  --encoders <n>      Threads encoding results (default: 2)\n"
+              << "  --tile <px>         Evaluate in tiles of this size to bound memory (default: off)\n"
+              << "  --trace <file>      Write a Chrome trace of all node calls\n"
+              << "  --gpu               Run supported nodes on the GPU via OpenCL (ignored with --tile)\n"
+              << "  --depth <8|16|32>   Working precision: 8 or 16 bits, or 32-bit float (default: the graph's)\n"
+              << "  --plugins <path>    Node plugin library, or directory of them; repeatable\n"
+              << "                      (in addition to $NODEIMG_PLUGIN_PATH)\n";
+}
+
+bool parseArgs(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--graph" && hasValue) options.graphPath = argv[++i];
+        else if (arg == "--output" && hasValue) options.outputDir = argv[++i];
+        else if (arg == "--input-node" && hasValue) options.inputNodeId = std::atoi(argv[++i]);
+        else if (arg == "--workers" && hasValue) options.workers = std::atoi(argv[++i]);
+        else if (arg == "--encoders" && hasValue) options.encoders = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--tile" && hasValue) options.tileSize = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--trace" && hasValue) options.tracePath = argv[++i];
+        else if (arg == "--gpu") options.gpu = true;
+        else if (arg == "--plugins" && hasValue) options.plugins.push_back(argv[++i]);
+        else if (arg == "--depth" && hasValue) {
+            std::string bits = argv[++i];
+            if (bits == "8") options.depth = CV_8U;
+            else if (bits == "16") options.depth = CV_16U;
+            else if (bits == "32") options.depth = CV_32F;
+            else return false;
+        }
+        else if (arg == "-h" || arg == "--help") return false;
+        else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        }
+        else options.inputs.push_back(arg);
+    }
+    return !options.graphPath.empty() && !options.inputs.empty();
+}
+
+bool isImageFile(const fs::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp" ||
+           ext == ".tif" || ext == ".tiff" || ext == ".exr";
+}
+
+// Expands directories (non-recursively) into their image files, sorted by name
+std::vector<fs::path> collectInputs(const std::vector<std::string>& inputs) {
+    std::vector<fs::path> files;
+    for (const auto& input : inputs) {
+        std::error_code ec;
+        if (fs::is_directory(input, ec)) {
+            std::vector<fs::path> found;
+            for (const auto& entry : fs::directory_iterator(input, ec)) {
+                if (entry.is_regular_file() && isImageFile(entry.path())) {
+                    found.push_back(entry.path());
+                }
+            }
+            std::sort(found.begin(), found.end());
+            files.insert(files.end(), found.begin(), found.end());
+        } else {
+            files.emplace_back(input);
+        }
+    }
+    return files;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    // Float graphs load and save OpenEXR
+    ImageEncoder::enableOpenExr();
+
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    // Frames are all alike, so the pool turns almost every allocation into a reuse
+    BufferPool::install();
+
+    // Before the graph is read, so it can use plugin nodes
+    NodeRegistry& registry = NodeRegistry::instance();
+    registry.loadPlugins(NodeRegistry::defaultSearchPath());
+    for (const auto& plugin : options.plugins) {
+        if (!registry.loadPlugin(plugin)) return 1;
+    }
+
+    NodeEditor editor;
+    editor.setWorkerCount(options.workers);
+    // Every frame is a new input, so memoized results would never be reused,
+    // and intermediates can go back to the pool as soon as they are consumed
+    editor.getResultCache().setBudget(0);
+    editor.setRetainIntermediates(false);
+    if (options.gpu) {
+        editor.setGpuEnabled(true);
+        if (!editor.isGpuEnabled()) std::cerr << "No OpenCL device available; running on the CPU" << std::endl;
+    }
+    editor.getProfiler().setTracing(!options.tracePath.empty());
+    if (!GraphSerializer::load(editor, options.graphPath)) {
+        return 1;
+    }
+    if (options.depth >= 0) editor.setWorkingDepth(options.depth);
+    const int workingDepth = editor.getWorkingDepth();
+
+    ImageInputNode* input = nullptr;
+    std::vector<OutputNode*> outputs;
+    for (const auto& node : editor.getNodes()) {
+        if (auto* in = dynamic_cast<ImageInputNode*>(node.get())) {
+            if (!input && (options.inputNodeId < 0 || in->id == options.inputNodeId)) {
+                input = in;
+            }
+        } else if (auto* out = dynamic_cast<OutputNode*>(node.get())) {
+            outputs.push_back(out);
+        }
+    }
+    if (!input) {
+        std::cerr << "Graph has no matching Image Input node" << std::endl;
+        return 1;
+    }
+    if (outputs.empty()) {
+        std::cerr << "Graph has no Output node" << std::endl;
+        return 1;
+    }
+
+    std::vector<fs::path> files = collectInputs(options.inputs);
+    if (files.empty()) {
+        std::cerr << "No input images found" << std::endl;
+        return 1;
+    }
+
+    std::error_code ec;
+    fs::create_directories(options.outputDir, ec);
+
+    // Two slots per stage is enough to keep every stage busy
+    BoundedQueue<DecodedImage> decoded(2);
+    ImageEncoder encoder(options.encoders);
+    std::atomic<int> failures{0};
+
+    std::thread decoder([&] {
+        for (const auto& file : files) {
+            cv::Mat image = cv::imread(file.string(), cv::IMREAD_COLOR | cv::IMREAD_ANYDEPTH);
+            if (image.empty()) {
+                std::cerr << "Cannot decode " << file << std::endl;
+                ++failures;
+                continue;
+            }
+            // Converted here, so the Image Input node passes it on as it is
+            image = BaseNode::convertDepth(image, workingDepth);
+            if (!decoded.push({file, image})) break;
+        }
+        decoded.close();
+    });
+
+    // Graph evaluation stays on this thread; it fans out to the editor's pool
+    size_t processed = 0;
+    size_t peakBytes = 0;
+    DecodedImage frame;
+    while (decoded.pop(frame)) {
+        input->setImage(frame.image);
+        if (options.tileSize > 0) {
+            editor.processGraphTiled(options.tileSize);
+        } else {
+            editor.processGraph();
+        }
+        peakBytes = std::max(peakBytes, editor.getProfiler().lastPass().peakBytes);
+
+        for (const OutputNode* out : outputs) {
+            if (out->result().empty()) {
+                std::cerr << "Output " << out->id << " produced nothing for "
+                          << frame.source << std::endl;
+                ++failures;
+                continue;
+            }
+            std::string stem = frame.source.stem().string();
+            if (outputs.size() > 1) stem += "_" + std::to_string(out->id);
+            fs::path target = fs::path(options.outputDir) / (stem + out->fileExtension());
+            // Shares the graph's buffer; pins are never written in place
+            encoder.submit({target.string(), out->result(), out->encodeParams()});
+        }
+        ++processed;
+    }
+
+    decoder.join();
+    encoder.finish();
+    failures += encoder.failures();
+
+    if (!options.tracePath.empty()) {
+        editor.getProfiler().exportTrace(options.tracePath);
+    }
+
+    std::cout << "Processed " << processed << " of " << files.size() << " images";
+    if (failures) std::cout << ", " << failures.load() << " failures";
+    std::cout << "; peak working set " << peakBytes / (1024 * 1024) << " MB" << std::endl;
+    return failures ? 1 : 0;
+}
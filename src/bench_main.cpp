@@ -0,0 +1,342 @@
+// bench_main.cpp
+// nodeimg-bench: Google Benchmark suite timing every node type's process()
+// over a matrix of resolutions and pixel formats, plus whole graphs through
+// NodeEditor::processGraph(). Results are machine-readable with
+// --benchmark_out=<file> --benchmark_out_format=json.
+#include "BufferPool.hpp"
+#include "NodeEditor.hpp"
+#include "nodes/ImageInputNode.hpp"
+#include "nodes/BrightnessContrastNode.hpp"
+#include "nodes/ColorChannelSplitterNode.hpp"
+#include "nodes/BlurNode.hpp"
+#include "nodes/ThresholdNode.hpp"
+#include "nodes/EdgeDetectionNode.hpp"
+#include "nodes/BlendNode.hpp"
+#include "nodes/NoiseNode.hpp"
+#include "nodes/ConvolutionNode.hpp"
+#include <benchmark/benchmark.h>
+#include <opencv2/core.hpp>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Resolution {
+    const char* name;
+    int width;
+    int height;
+};
+
+const Resolution kResolutions[] = {
+    {"1MP", 1024, 1024},
+    {"12MP", 4000, 3000},
+    {"50MP", 8192, 6144},
+};
+
+struct Format {
+    const char* name;
+    int type;
+};
+
+const Format kFormats[] = {
+    {"8UC1", CV_8UC1},
+    {"8UC3", CV_8UC3},
+    {"8UC4", CV_8UC4},
+    {"16UC3", CV_16UC3},
+    {"32FC3", CV_32FC3},
+};
+
+using Params = std::vector<std::pair<const char*, float>>;
+
+// Assigns the listed parameters through the node's own serializeParams(),
+// the way a saved graph is loaded; everything else keeps its default
+class ParamSetter : public ParamArchive {
+public:
+    explicit ParamSetter(const Params& params) : params(params) {}
+
+    bool loading() const override { return true; }
+    void field(const char* key, int& value) override {
+        if (const float* v = find(key)) value = static_cast<int>(std::lround(*v));
+    }
+    void field(const char* key, float& value) override {
+        if (const float* v = find(key)) value = *v;
+    }
+    void field(const char* key, bool& value) override {
+        if (const float* v = find(key)) value = *v != 0.0f;
+    }
+    void field(const char*, std::string&) override {}
+    void field(const char*, std::vector<float>&) override {}
+
+private:
+    const float* find(const char* key) const {
+        for (const auto& param : params) {
+            if (std::string(param.first) == key) return &param.second;
+        }
+        return nullptr;
+    }
+
+    const Params& params;
+};
+
+void setParams(BaseNode& node, const Params& params) {
+    ParamSetter setter(params);
+    node.serializeParams(setter);
+    node.dirty = true;
+}
+
+// Random test images, generated once per shape and kept while they fit
+const cv::Mat& testImage(const Resolution& res, int type, int seed) {
+    static std::map<std::tuple<int, int, int, int>, cv::Mat> images;
+    static size_t bytes = 0;
+    const size_t kBudget = size_t(2) * 1024 * 1024 * 1024;
+
+    auto key = std::make_tuple(res.width, res.height, type, seed);
+    auto it = images.find(key);
+    if (it != images.end()) return it->second;
+
+    cv::Mat image(res.height, res.width, type);
+    const double top = CV_MAT_DEPTH(type) == CV_8U ? 256.0 : CV_MAT_DEPTH(type) == CV_16U ? 65536.0 : 1.0;
+    cv::setRNGSeed(seed + 1);
+    cv::randu(image, cv::Scalar::all(0.0), cv::Scalar::all(top));
+
+    const size_t size = image.total() * image.elemSize();
+    if (bytes + size > kBudget) {
+        images.clear();
+        bytes = 0;
+    }
+    bytes += size;
+    return images.emplace(key, image).first->second;
+}
+
+void reportThroughput(benchmark::State& state, size_t pixels, size_t bytes) {
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * pixels));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+    state.counters["MPix/s"] = benchmark::Counter(pixels / 1e6, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+// Times node.process() on inputs that stay the same for every iteration.
+// One untimed call first: it reports unsupported formats and warms the
+// buffer pool, so the loop measures the steady state of a live graph.
+void runNode(benchmark::State& state, BaseNode& node, const std::vector<cv::Mat>& inputs) {
+    size_t bytes = 0;
+    for (size_t i = 0; i < inputs.size() && i < node.inputs.size(); ++i) {
+        node.inputs[i].data = inputs[i];
+        node.inputs[i].connected = true;
+        bytes += inputs[i].total() * inputs[i].elemSize();
+    }
+    try {
+        node.process();
+    } catch (const cv::Exception& e) {
+        state.SkipWithError(e.what());
+        return;
+    }
+
+    for (auto _ : state) {
+        node.process();
+        benchmark::DoNotOptimize(node.outputs.empty() ? nullptr : node.outputs[0].data.data);
+    }
+
+    size_t pixels = inputs.empty() ? 0 : inputs[0].total();
+    if (pixels == 0 && !node.outputs.empty()) pixels = node.outputs[0].data.total();
+    reportThroughput(state, pixels, bytes);
+}
+
+struct NodeCase {
+    std::string name; // Node/variant
+    BaseNode* (*create)();
+    Params params;
+    int inputs;
+};
+
+template <typename Node>
+BaseNode* make() {
+    return new Node();
+}
+
+std::vector<NodeCase> nodeCases() {
+    std::vector<NodeCase> cases;
+
+    cases.push_back({"BrightnessContrast", make<BrightnessContrastNode>,
+                     {{"brightness", 20.0f}, {"contrast", 1.2f}}, 1});
+    cases.push_back({"ColorChannelSplitter", make<ColorChannelSplitterNode>, {}, 1});
+
+    cases.push_back({"Blur/gaussian_r2", make<BlurNode>, {{"radius", 2}}, 1});
+    cases.push_back({"Blur/gaussian_r8", make<BlurNode>, {{"radius", 8}}, 1});
+    cases.push_back({"Blur/directional_r8", make<BlurNode>,
+                     {{"radius", 8}, {"directional", 1}, {"angle", 30.0f}}, 1});
+
+    // Dense, separable and DFT paths of FilterKernel
+    cases.push_back({"Convolution/sharpen_3", make<ConvolutionNode>,
+                     {{"kernelSize", 3}, {"preset", ConvolutionNode::PRESET_SHARPEN}}, 1});
+    cases.push_back({"Convolution/box_15", make<ConvolutionNode>,
+                     {{"kernelSize", 15}, {"preset", ConvolutionNode::PRESET_BLUR}}, 1});
+    cases.push_back({"Convolution/edge_21", make<ConvolutionNode>,
+                     {{"kernelSize", 21}, {"preset", ConvolutionNode::PRESET_EDGE_DETECT}}, 1});
+
+    const char* edgeMethods[] = {"sobel", "canny", "laplacian"};
+    for (int m = 0; m < 3; ++m) {
+        cases.push_back({std::string("EdgeDetection/") + edgeMethods[m], make<EdgeDetectionNode>,
+                         {{"method", static_cast<float>(m)}, {"kernelSize", 3}}, 1});
+    }
+
+    const char* blendModes[] = {"normal", "multiply", "screen", "overlay", "difference"};
+    for (int m = 0; m < 5; ++m) {
+        cases.push_back({std::string("Blend/") + blendModes[m], make<BlendNode>,
+                         {{"blendMode", static_cast<float>(m)}, {"opacity", 0.5f}}, 2});
+    }
+
+    const char* thresholdMethods[] = {"binary", "adaptive", "otsu"};
+    for (int m = 0; m < 3; ++m) {
+        cases.push_back({std::string("Threshold/") + thresholdMethods[m], make<ThresholdNode>,
+                         {{"method", static_cast<float>(m)}, {"thresholdValue", 128.0f}}, 1});
+    }
+    return cases;
+}
+
+void registerNodeBenchmarks() {
+    for (const NodeCase& node : nodeCases()) {
+        for (const Resolution& res : kResolutions) {
+            for (const Format& format : kFormats) {
+                std::string name = "Node/" + node.name + "/" + res.name + "/" + format.name;
+                benchmark::RegisterBenchmark(name.c_str(), [node, res, format](benchmark::State& state) {
+                    std::unique_ptr<BaseNode> instance(node.create());
+                    setParams(*instance, node.params);
+                    std::vector<cv::Mat> inputs;
+                    for (int i = 0; i < node.inputs; ++i) {
+                        inputs.push_back(testImage(res, format.type, i));
+                    }
+                    runNode(state, *instance, inputs);
+                })->Unit(benchmark::kMillisecond)->UseRealTime();
+            }
+        }
+    }
+
+    // Generators have no input; their output is always 8-bit BGR
+    const char* noiseTypes[] = {"perlin", "simplex", "worley"};
+    for (int type = 0; type < 3; ++type) {
+        for (const Resolution& res : kResolutions) {
+            std::string name = std::string("Node/Noise/") + noiseTypes[type] + "/" + res.name;
+            benchmark::RegisterBenchmark(name.c_str(), [type, res](benchmark::State& state) {
+                NoiseNode noise;
+                setParams(noise, {{"noiseType", static_cast<float>(type)},
+                                  {"width", static_cast<float>(res.width)},
+                                  {"height", static_cast<float>(res.height)},
+                                  {"octaves", 4}});
+                runNode(state, noise, {});
+            })->Unit(benchmark::kMillisecond)->UseRealTime();
+        }
+    }
+}
+
+// Graph building blocks on the public editor API
+BaseNode* add(NodeEditor& editor, const char* type, const Params& params = {}) {
+    BaseNode* node = editor.addNode(type);
+    setParams(*node, params);
+    return node;
+}
+
+void link(NodeEditor& editor, BaseNode* from, BaseNode* to, int input = 0) {
+    editor.connect(from->outputs[0].id, to->inputs[input].id);
+}
+
+// Photo-style chain: tone, blur, sharpen
+BaseNode* buildDevelop(NodeEditor& editor, const Resolution&) {
+    BaseNode* input = add(editor, "Image Input");
+    BaseNode* tone = add(editor, "Brightness/Contrast", {{"brightness", 10.0f}, {"contrast", 1.1f}});
+    BaseNode* blur = add(editor, "Blur", {{"radius", 3}});
+    BaseNode* sharpen = add(editor, "Convolution",
+        {{"kernelSize", 3}, {"preset", ConvolutionNode::PRESET_SHARPEN}});
+    BaseNode* output = add(editor, "Output");
+    link(editor, input, tone);
+    link(editor, tone, blur);
+    link(editor, blur, sharpen);
+    link(editor, sharpen, output);
+    return input;
+}
+
+// Canny edges screened back over the input: a diamond with two branches
+BaseNode* buildEdges(NodeEditor& editor, const Resolution&) {
+    BaseNode* input = add(editor, "Image Input");
+    BaseNode* edges = add(editor, "Edge Detection", {{"method", 1}});
+    BaseNode* blend = add(editor, "Blend", {{"blendMode", 2}, {"opacity", 0.7f}});
+    BaseNode* output = add(editor, "Output");
+    link(editor, input, edges);
+    link(editor, input, blend, 0);
+    link(editor, edges, blend, 1);
+    link(editor, blend, output);
+    return input;
+}
+
+// Generated texture multiplied into the image, then thresholded
+BaseNode* buildComposite(NodeEditor& editor, const Resolution& res) {
+    BaseNode* input = add(editor, "Image Input");
+    BaseNode* noise = add(editor, "Noise Generator", {{"noiseType", 0},
+                                                    {"width", static_cast<float>(res.width)},
+                                                    {"height", static_cast<float>(res.height)}});
+    BaseNode* blend = add(editor, "Blend", {{"blendMode", 1}, {"opacity", 1.0f}});
+    BaseNode* threshold = add(editor, "Threshold", {{"method", 1}});
+    BaseNode* output = add(editor, "Output");
+    link(editor, input, blend, 0);
+    link(editor, noise, blend, 1);
+    link(editor, blend, threshold);
+    link(editor, threshold, output);
+    return input;
+}
+
+// Each iteration feeds the same frame again, as the batch runner does with
+// a new one: everything downstream of the input is evaluated, nothing is
+// memoized. Generators that do not depend on the input run only once.
+void registerGraphBenchmarks() {
+    using Builder = BaseNode* (*)(NodeEditor&, const Resolution&);
+    const std::pair<const char*, Builder> graphs[] = {
+        {"develop", buildDevelop},
+        {"edges", buildEdges},
+        {"composite", buildComposite},
+    };
+    for (const auto& graph : graphs) {
+        for (const Resolution& res : kResolutions) {
+            std::string name = std::string("Graph/") + graph.first + "/" + res.name + "/8UC3";
+            Builder build = graph.second;
+            benchmark::RegisterBenchmark(name.c_str(), [build, res](benchmark::State& state) {
+                NodeEditor editor;
+                editor.getResultCache().setBudget(0);
+                editor.setRetainIntermediates(false);
+                auto* input = static_cast<ImageInputNode*>(build(editor, res));
+                const cv::Mat& image = testImage(res, CV_8UC3, 0);
+
+                input->setImage(image);
+                editor.processGraph();
+                for (auto _ : state) {
+                    input->setImage(image);
+                    editor.processGraph();
+                }
+
+                reportThroughput(state, image.total(), image.total() * image.elemSize());
+                state.counters["peak MB"] = static_cast<double>(editor.getProfiler().lastPass().peakBytes) /
+                                            (1024.0 * 1024.0);
+            })->Unit(benchmark::kMillisecond)->UseRealTime();
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    // Same allocator as the editor and the batch runner
+    BufferPool::install();
+
+    registerNodeBenchmarks();
+    registerGraphBenchmarks();
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
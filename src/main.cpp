@@ -4,10 +4,56 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 #include <imnodes.h>
+#include "portable-file-dialogs.h"
+#include "BufferPool.hpp"
+#include "GLPreviewTexture.hpp"
+#include "FramePrefetcher.hpp"
+#include "GraphSerializer.hpp"
+#include "ImageEncoder.hpp"
 #include "NodeEditor.hpp"
+#include "NodeRegistry.hpp"
+#include "nodes/OutputNode.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
 #include <iostream>
+#include <memory>
+#include <thread>
+
+namespace {
+
+// Frames are drawn only while something on screen can change: for a few
+// frames after each input event, and once whenever a background evaluation
+// or save has finished or a scheduled pass is due. In between the loop
+// sleeps in glfwWaitEvents*(), so an idle editor uses no CPU or GPU.
+constexpr int kSettleFrames = 3;      // ImGui settles hover and layout over a few frames
+constexpr double kCaretBlink = 0.5;   // Redraw interval while a text field has focus
+constexpr std::chrono::milliseconds kPowerSavingFrame{33}; // Frame cap in power-saving mode
+
+// Bumped by the GLFW callbacks below; ImGui's backend chains to them
+int inputEvents = 0;
+
+void watchInput(GLFWwindow* window) {
+    glfwSetCursorPosCallback(window, [](GLFWwindow*, double, double) { ++inputEvents; });
+    glfwSetMouseButtonCallback(window, [](GLFWwindow*, int, int, int) { ++inputEvents; });
+    glfwSetScrollCallback(window, [](GLFWwindow*, double, double) { ++inputEvents; });
+    glfwSetKeyCallback(window, [](GLFWwindow*, int, int, int, int) { ++inputEvents; });
+    glfwSetCharCallback(window, [](GLFWwindow*, unsigned int) { ++inputEvents; });
+    glfwSetCursorEnterCallback(window, [](GLFWwindow*, int) { ++inputEvents; });
+    glfwSetWindowFocusCallback(window, [](GLFWwindow*, int) { ++inputEvents; });
+    glfwSetFramebufferSizeCallback(window, [](GLFWwindow*, int, int) { ++inputEvents; });
+    glfwSetWindowRefreshCallback(window, [](GLFWwindow*) { ++inputEvents; });
+}
+
+} // namespace
 
 int main() {
+    // Float graphs load and save OpenEXR
+    ImageEncoder::enableOpenExr();
+
+    // Recycle image buffers between evaluations; must precede any cv::Mat
+    BufferPool::install();
+
     // Set GLFW error callback
     glfwSetErrorCallback([](int error, const char* description) {
         std::cerr << "GLFW Error " << error << ": " << description << std::endl;
@@ -46,6 +92,9 @@ int main() {
         return 1;
     }
 
+    // Node previews are uploaded through the GL context created above
+    PreviewTexture::setFactory([] { return std::make_unique<GLPreviewTexture>(); });
+
     // Setup Dear ImGui context
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -57,7 +106,9 @@ ImGuiStyle& imguiStyle = ImGui::GetStyle();
 imguiStyle.ItemSpacing = ImVec2(4, 2);  // Reduced from (8,4)
 imguiStyle.FramePadding = ImVec2(4, 2); // Reduced from (8,4)
     ImGuiIO& io = ImGui::GetIO();
-    (void)io;
+
+    // Before the backend installs its callbacks, so that it chains to these
+    watchInput(window);
 
     // Setup Platform/Renderer backends
     const char* glsl_version = "#version 410";
@@ -77,12 +128,46 @@ imguiStyle.FramePadding = ImVec2(4, 2); // Reduced from (8,4)
     ImGui::StyleColorsDark();
     ImNodes::StyleColorsDark();
 
+    // Node types from plugins join the built-in ones before any graph is built
+    NodeRegistry::instance().loadPlugins(NodeRegistry::defaultSearchPath());
+
     // Initialize node editor
     NodeEditor editor;
 
+    // Work finishing on other threads wakes the loop for one frame
+    editor.setOnResultsReady([] { glfwPostEmptyEvent(); });
+    ImageEncoder::shared().setOnJobDone([] { glfwPostEmptyEvent(); });
+    FramePrefetcher::setOnAwaitedFrame([] { glfwPostEmptyEvent(); });
+
+    bool powerSaving = false;
+    int framesLeft = kSettleFrames;
+    auto lastFrame = std::chrono::steady_clock::now();
+
     // Main loop
     while (!glfwWindowShouldClose(window)) {
-        glfwPollEvents();
+        if (glfwGetWindowAttrib(window, GLFW_ICONIFIED)) {
+            // Nothing is visible; results are picked up once restored
+            glfwWaitEvents();
+            framesLeft = kSettleFrames;
+            continue;
+        }
+
+        const int eventsBefore = inputEvents;
+        if (framesLeft > 0) {
+            // Interaction: follow the display, or the cap when saving power
+            if (powerSaving) std::this_thread::sleep_until(lastFrame + kPowerSavingFrame);
+            glfwPollEvents();
+        } else {
+            double timeout = editor.idleTimeout();
+            if (io.WantTextInput && io.ConfigInputTextCursorBlink) {
+                timeout = timeout < 0.0 ? kCaretBlink : std::min(timeout, kCaretBlink);
+            }
+            if (timeout < 0.0) glfwWaitEvents();
+            else glfwWaitEventsTimeout(timeout);
+            framesLeft = 1; // Input, a finished job or a due pass: draw what changed
+        }
+        if (inputEvents != eventsBefore) framesLeft = kSettleFrames;
+        --framesLeft;
 
         // Start new ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
@@ -93,20 +178,69 @@ imguiStyle.FramePadding = ImVec2(4, 2); // Reduced from (8,4)
         if (ImGui::BeginMainMenuBar()) {
             if (ImGui::BeginMenu("File")) {
                 if (ImGui::MenuItem("New")) editor.clear();
+                if (ImGui::MenuItem("Open Graph...")) {
+                    auto file = pfd::open_file("Open graph", ".", {"Graph Files", "*.nig *.json"});
+                    if (!file.result().empty()) GraphSerializer::load(editor, file.result()[0]);
+                }
+                if (ImGui::MenuItem("Save Graph...")) {
+                    auto file = pfd::save_file("Save graph", "graph.nig", {"Graph Files", "*.nig"});
+                    if (!file.result().empty()) GraphSerializer::save(editor, file.result());
+                }
+                if (ImGui::MenuItem("Export Graph as JSON...")) {
+                    auto file = pfd::save_file("Export graph", "graph.json", {"JSON", "*.json"});
+                    if (!file.result().empty()) GraphSerializer::exportJson(editor, file.result());
+                }
+                if (ImGui::MenuItem("Save All Outputs...")) {
+                    // Every Output node is queued at once and encoded in parallel
+                    auto folder = pfd::select_folder("Save all outputs", ".").result();
+                    if (!folder.empty()) {
+                        for (const auto& node : editor.getNodes()) {
+                            if (auto* out = dynamic_cast<OutputNode*>(node.get())) {
+                                out->saveImage((std::filesystem::path(folder) /
+                                                ("output_" + std::to_string(out->id))).string());
+                            }
+                        }
+                    }
+                }
                 if (ImGui::MenuItem("Exit")) glfwSetWindowShouldClose(window, true);
                 ImGui::EndMenu();
             }
             if (ImGui::BeginMenu("Nodes")) {
-                if (ImGui::MenuItem("Image Input")) editor.addNode<NodeType::ImageInput>();
-                if (ImGui::MenuItem("Output")) editor.addNode<NodeType::Output>();
-                if (ImGui::MenuItem("Brightness/Contrast")) editor.addNode<NodeType::BrightnessContrast>();
-                if (ImGui::MenuItem("Channel Splitter")) editor.addNode<NodeType::ColorChannelSplitter>();
-                if (ImGui::MenuItem("Blur")) editor.addNode<NodeType::Blur>();
-                if (ImGui::MenuItem("Threshold")) editor.addNode<NodeType::Threshold>();
-                if (ImGui::MenuItem("Edge Detection")) editor.addNode<NodeType::EdgeDetection>();
-                if (ImGui::MenuItem("Blend")) editor.addNode<NodeType::Blend>();
-                if (ImGui::MenuItem("Noise")) editor.addNode<NodeType::Noise>();
-                if (ImGui::MenuItem("Convolution")) editor.addNode<NodeType::Convolution>();
+                // Built-in types first, then each plugin's, in registration order
+                const auto& types = NodeRegistry::instance().entries();
+                for (size_t i = 0; i < types.size(); ++i) {
+                    if (i > 0 && types[i].origin != types[i - 1].origin) ImGui::Separator();
+                    if (ImGui::MenuItem(types[i].label.c_str())) editor.addNode(types[i].name);
+                }
+                ImGui::EndMenu();
+            }
+            if (ImGui::BeginMenu("Evaluation")) {
+                bool gpu = editor.isGpuEnabled();
+                if (ImGui::MenuItem("Use GPU (OpenCL)", nullptr, &gpu, NodeEditor::isGpuAvailable())) {
+                    editor.setGpuEnabled(gpu);
+                }
+                bool proxies = editor.getProxyWidth() > 0;
+                if (ImGui::MenuItem("Proxy Previews While Editing", nullptr, &proxies)) {
+                    editor.setProxyWidth(proxies ? NodeEditor::kDefaultProxyWidth : 0);
+                }
+                if (ImGui::BeginMenu("Working Precision")) {
+                    const struct { const char* label; int depth; } precisions[] = {
+                        {"8-bit", CV_8U}, {"16-bit", CV_16U}, {"32-bit Float", CV_32F}};
+                    for (const auto& precision : precisions) {
+                        if (ImGui::MenuItem(precision.label, nullptr, editor.getWorkingDepth() == precision.depth)) {
+                            editor.setWorkingDepth(precision.depth);
+                        }
+                    }
+                    ImGui::EndMenu();
+                }
+                ImGui::EndMenu();
+            }
+            if (ImGui::BeginMenu("View")) {
+                // Caps interactive redraws at 30 fps and stops the caret blinking,
+                // which would otherwise wake an idle editor twice a second
+                if (ImGui::MenuItem("Power Saving", nullptr, &powerSaving)) {
+                    io.ConfigInputTextCursorBlink = !powerSaving;
+                }
                 ImGui::EndMenu();
             }
             ImGui::EndMainMenuBar();
@@ -121,8 +255,13 @@ imguiStyle.FramePadding = ImVec2(4, 2); // Reduced from (8,4)
         editor.drawProperties();
         ImGui::End();
 
-        // Process node graph
-        editor.processGraph();
+        ImGui::Begin("Profiler");
+        editor.drawProfiler();
+        ImGui::End();
+
+        // Process node graph in the background; the UI keeps showing the last
+        // completed results until the new ones are ready
+        editor.evaluateAsync();
 
         // Rendering
         ImGui::Render();
@@ -134,9 +273,17 @@ imguiStyle.FramePadding = ImVec2(4, 2); // Reduced from (8,4)
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
         glfwSwapBuffers(window);
+        lastFrame = std::chrono::steady_clock::now();
     }
 
-    // Cleanup
+    // Cleanup. Whatever can still call into GL or GLFW goes first: the
+    // evaluator and the nodes with their preview textures and prefetchers,
+    // then saves still being written.
+    editor.shutdown();
+    ImageEncoder::shared().finish();
+    ImageEncoder::shared().setOnJobDone(nullptr);
+    FramePrefetcher::setOnAwaitedFrame(nullptr);
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImNodes::DestroyContext();
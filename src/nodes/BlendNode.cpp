@@ -3,8 +3,12 @@
 // using different mathematical algorithms for visual composition effects
 
 #include "BlendNode.hpp"
+#include "PixelKernel.hpp"
 #include <imgui.h>
 #include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 
 
 
@@ -29,41 +33,185 @@ int BlendNode::getPinType(int pinId) const {
     return 0; // All pins handle images
 }
 
+BaseNode* BlendNode::clone() const {
+    return new BlendNode(*this);
+}
+
+void BlendNode::serializeParams(ParamArchive& ar) {
+    ar.field("blendMode", blendMode);
+    ar.field("opacity", opacity);
+}
+
 void BlendNode::process() {
     if (inputs.size() < 2 || inputs[0].data.empty() || inputs[1].data.empty()) return;
 
-    // Convert inputs to 3-channel if grayscale
     cv::Mat base, blend;
-    if (inputs[0].data.channels() == 1) {
-        cv::cvtColor(inputs[0].data, base, cv::COLOR_GRAY2BGR);
-    } else {
-        base = inputs[0].data.clone();
+    prepareInputs(inputs[0].data, inputs[1].data, base, blend);
+
+    // A gray pair stays gray; it is expanded only where color is needed
+    outputs[0].data = blendImages(base, blend);
+}
+
+void BlendNode::processGpu() {
+    if (inputs.size() < 2 || inputs[0].gpu.empty() || inputs[1].gpu.empty()) return;
+
+    cv::UMat base, blend;
+    prepareInputs(inputs[0].gpu, inputs[1].gpu, base, blend);
+
+    outputs[0].gpu = blendImagesGpu(base, blend);
+}
+
+/**
+ * Brings both inputs to a common channel count, depth and size, for either
+ * backend (Image is cv::Mat or cv::UMat). The shared inputs are never
+ * modified; conversions go to new buffers.
+ */
+template <typename Image>
+void BlendNode::prepareInputs(const Image& baseIn, const Image& blendIn, Image& base, Image& blend) {
+    // Blend at the base image's depth; other depths are blended as float
+    const int depth = baseIn.depth();
+    const int workDepth = (depth == CV_8U || depth == CV_16U || depth == CV_32F) ? depth : CV_32F;
+
+    // Gray inputs are blended as gray, so a gray pair needs no conversion
+    base = baseIn;
+    blend = blendIn;
+    if (base.channels() != blend.channels()) {
+        const int channels = std::max(base.channels(), blend.channels());
+        base = matchChannels(base, channels);
+        blend = matchChannels(blend, channels);
     }
 
-    if (inputs[1].data.channels() == 1) {
-        cv::cvtColor(inputs[1].data, blend, cv::COLOR_GRAY2BGR);
-    } else {
-        blend = inputs[1].data.clone();
+    if (base.depth() != workDepth) {
+        Image converted;
+        base.convertTo(converted, workDepth, depthMax(workDepth) / depthMax(base.depth()));
+        base = converted;
+    }
+    if (blend.depth() != workDepth) {
+        Image converted;
+        blend.convertTo(converted, workDepth, depthMax(workDepth) / depthMax(blend.depth()));
+        blend = converted;
     }
 
-    // Ensure same size
+    // Ensure same size (resized into a new buffer, the input is left untouched)
     if (base.size() != blend.size()) {
-        cv::resize(blend, blend, base.size(), 0, 0, cv::INTER_LINEAR);
+        Image resized;
+        cv::resize(blend, resized, base.size(), 0, 0, cv::INTER_LINEAR);
+        blend = resized;
+    }
+}
+
+/**
+ * Brings an image to the given channel count (1, 3 or 4) by the usual
+ * gray/BGR/BGRA conversions. Returns the input when it already matches.
+ */
+template <typename Image>
+Image BlendNode::matchChannels(const Image& image, int channels) {
+    if (image.channels() == channels) return image;
+    Image converted;
+    if (image.channels() == 1) {
+        cv::cvtColor(image, converted, channels == 4 ? cv::COLOR_GRAY2BGRA : cv::COLOR_GRAY2BGR);
+    } else if (channels == 4) {
+        cv::cvtColor(image, converted, cv::COLOR_BGR2BGRA);
+    } else {
+        cv::cvtColor(image, converted, cv::COLOR_BGRA2BGR);
     }
+    return converted;
+}
+
+namespace {
 
-    // Convert to floating point with normalization
-    cv::Mat baseFloat, blendFloat;
-    base.convertTo(baseFloat, CV_32FC3, 1.0/255.0);
-    blend.convertTo(blendFloat, CV_32FC3, 1.0/255.0);
+// Fixed-point arithmetic per channel depth. Products are divided by the
+// maximum and rounded to nearest, as the former float round trip did.
+template <typename T> struct IntegerDepth;
 
-    cv::Mat resultFloat = blendImages(baseFloat, blendFloat);
+template <> struct IntegerDepth<unsigned char> {
+    using Wide = uint32_t;
+    static constexpr Wide kMax = 255;
+    static Wide scale(Wide v) { return (v + 127) / 255; }
+};
 
-    // Convert back to original format
-    resultFloat.convertTo(outputs[0].data, CV_8UC3, 255.0);
+template <> struct IntegerDepth<unsigned short> {
+    using Wide = uint64_t;
+    static constexpr Wide kMax = 65535;
+    static Wide scale(Wide v) { return (v + 32767) / 65535; }
+};
+
+// One mode over a run of interleaved channel values. The mode is a template
+// argument so each inner loop is branch-free and can be vectorized.
+template <int Mode, typename T>
+void blendRun(const T* a, const T* b, T* r, int n, uint32_t weight, float) {
+    using D = IntegerDepth<T>;
+    using Wide = typename D::Wide;
+    const Wide w = weight;              // Base weight, Q16
+    const Wide wInv = (1u << 16) - weight;
+    for (int i = 0; i < n; i++) {
+        const Wide x = a[i];
+        const Wide y = b[i];
+        Wide v;
+        switch (Mode) {
+            case 1: // Multiply
+                v = D::scale(x * y);
+                break;
+            case 2: // Screen
+                v = D::kMax - D::scale((D::kMax - x) * (D::kMax - y));
+                break;
+            case 3: // Overlay
+                v = (2 * x < D::kMax) ? D::scale(2 * x * y)
+                                      : D::kMax - D::scale(2 * (D::kMax - x) * (D::kMax - y));
+                break;
+            case 4: // Difference
+                v = x > y ? x - y : y - x;
+                break;
+            default: // Normal
+                v = (x * w + y * wInv + (1u << 15)) >> 16;
+                break;
+        }
+        r[i] = static_cast<T>(v);
+    }
+}
+
+// Float images keep the plain formulas
+template <int Mode>
+void blendRun(const float* a, const float* b, float* r, int n, uint32_t, float opacity) {
+    for (int i = 0; i < n; i++) {
+        const float x = a[i];
+        const float y = b[i];
+        switch (Mode) {
+            case 1:  r[i] = x * y; break;
+            case 2:  r[i] = 1.0f - (1.0f - x) * (1.0f - y); break;
+            case 3:  r[i] = x < 0.5f ? 2.0f * x * y : 1.0f - 2.0f * (1.0f - x) * (1.0f - y); break;
+            case 4:  r[i] = std::abs(x - y); break;
+            default: r[i] = x * opacity + y * (1.0f - opacity); break;
+        }
+    }
+}
+
+template <typename T, int Mode>
+void blendRows(const cv::Mat& base, const cv::Mat& blend, cv::Mat& result, float opacity) {
+    // Rows are independent; split them over OpenCV's workers
+    const int width = base.cols * base.channels();
+    const uint32_t weight = static_cast<uint32_t>(cvRound(std::min(std::max(opacity, 0.0f), 1.0f) * 65536.0f));
+    forEachRow(base.rows, [&](int y) {
+        blendRun<Mode>(base.ptr<T>(y), blend.ptr<T>(y), result.ptr<T>(y), width, weight, opacity);
+    });
+}
+
+template <typename T>
+void blendDepth(int mode, const cv::Mat& base, const cv::Mat& blend, cv::Mat& result, float opacity) {
+    switch (mode) {
+        case 1:  blendRows<T, 1>(base, blend, result, opacity); break;
+        case 2:  blendRows<T, 2>(base, blend, result, opacity); break;
+        case 3:  blendRows<T, 3>(base, blend, result, opacity); break;
+        case 4:  blendRows<T, 4>(base, blend, result, opacity); break;
+        default: blendRows<T, 0>(base, blend, result, opacity); break;
+    }
 }
 
+} // namespace
+
 /**
- * Applies a specific blend algorithm to two floating-point images
+ * Applies a specific blend algorithm to two images of equal size, type and
+ * channel count (8-bit, 16-bit or float)
  * 
  * Implements various blend modes commonly found in image editing software:
  * - Normal: Simple alpha blending with opacity control
@@ -72,66 +220,76 @@ void BlendNode::process() {
  * - Overlay: Combines multiply and screen based on base image brightness
  * - Difference: Shows the absolute difference between images
  * 
- * The bottom/background image (normalized 0.0-1.0)
- * The top/foreground image (normalized 0.0-1.0)
- * The blended result as a floating-point image (normalized 0.0-1.0)
+ * Integer images are blended in fixed point directly on their own data;
+ * values are treated as fractions of the depth's maximum. Float images are
+ * taken to be normalized to 0.0-1.0.
  */
 
 cv::Mat BlendNode::blendImages(const cv::Mat& base, const cv::Mat& blend) {
-    cv::Mat result(base.size(), CV_32FC3);
+    cv::Mat result(base.size(), base.type());
+    
+    // Inputs were brought to one of the dispatched depths by prepareInputs()
+    dispatchDepth(base.depth(), [&](auto format) {
+        blendDepth<typename decltype(format)::Channel>(blendMode, base, blend, result, opacity);
+    });
     
-    switch(blendMode) {
+    return result;
+}
+
+/**
+ * The same modes on the GPU, composed from OpenCV's transparent-API
+ * operations. Values are scaled by the depth maximum like the CPU kernels.
+ */
+cv::UMat BlendNode::blendImagesGpu(const cv::UMat& base, const cv::UMat& blend) {
+    const double max = depthMax(base.depth());
+    cv::UMat result;
+
+    switch (blendMode) {
         case 1: // Multiply
-            cv::multiply(base, blend, result);
+            cv::multiply(base, blend, result, 1.0 / max);
             break;
-            
-        case 2: // Screen
-            result = cv::Scalar::all(1.0) - 
-                    (cv::Scalar::all(1.0) - base).mul(cv::Scalar::all(1.0) - blend);
+
+        case 2: { // Screen
+            cv::UMat invBase, invBlend, product;
+            cv::subtract(cv::Scalar::all(max), base, invBase);
+            cv::subtract(cv::Scalar::all(max), blend, invBlend);
+            cv::multiply(invBase, invBlend, product, 1.0 / max);
+            cv::subtract(cv::Scalar::all(max), product, result);
             break;
-            
-        case 3: // Overlay blend mode
-            // Combines multiply and screen modes
-            // Dark areas in base: multiply, Light areas in base: screen
-            for (int y = 0; y < base.rows; y++) {
-                for (int x = 0; x < base.cols; x++) {
-                    const cv::Vec3f& b = base.at<cv::Vec3f>(y, x);
-                    const cv::Vec3f& s = blend.at<cv::Vec3f>(y, x);
-                    cv::Vec3f& r = result.at<cv::Vec3f>(y, x);
-                    
-                    for (int c = 0; c < 3; c++) {
-                        r[c] = (b[c] < 0.5f) ? 
-                            2 * b[c] * s[c] : 
-                            1 - 2 * (1 - b[c]) * (1 - s[c]);
-                    }
-                }
-            }
+        }
+
+        case 3: { // Overlay: multiply where the base is dark, screen where it is light
+            cv::UMat invBase, invBlend, product, dark;
+            cv::subtract(cv::Scalar::all(max), base, invBase);
+            cv::subtract(cv::Scalar::all(max), blend, invBlend);
+            cv::multiply(invBase, invBlend, product, 2.0 / max);
+            cv::subtract(cv::Scalar::all(max), product, result);
+            cv::multiply(base, blend, product, 2.0 / max);
+            cv::compare(base, cv::Scalar::all(max * 0.5), dark, cv::CMP_LT);
+            product.copyTo(result, dark);
             break;
-            
-        case 4: // Difference blend mode
-            // Absolute difference between pixel values
-            // Shows where images differ, black where identical
+        }
+
+        case 4: // Difference
             cv::absdiff(base, blend, result);
             break;
-            
-        default:// Normal blend mode
-            // Simple alpha blending with opacity control
-            // Linear interpolation between base and blend images
+
+        default: // Normal
             cv::addWeighted(base, opacity, blend, 1.0f - opacity, 0.0f, result);
             break;
     }
-    
+
     return result;
 }
 
 void BlendNode::drawUI() {
     const char* modes[] = {"Normal", "Multiply", "Screen", "Overlay", "Difference"};
-    ImGui::Combo("Blend Mode", &blendMode, modes, IM_ARRAYSIZE(modes));
+    dirty |= ImGui::Combo("Blend Mode", &blendMode, modes, IM_ARRAYSIZE(modes));
 
      // Only show opacity slider for Normal blend mode since other modes
     // have their own fixed mathematical relationships
     
     if (blendMode == 0) { // Only show opacity for Normal mode
-        ImGui::SliderFloat("Opacity", &opacity, 0.0f, 1.0f);
+        dirty |= ImGui::SliderFloat("Opacity", &opacity, 0.0f, 1.0f);
     }
 }
@@ -27,6 +27,45 @@ int BlurNode::getPinType(int pinId) const {
     return 0; // Image type for all pins
 }
 
+BaseNode* BlurNode::clone() const {
+    return new BlurNode(*this);
+}
+
+void BlurNode::serializeParams(ParamArchive& ar) {
+    ar.field("radius", radius);
+    ar.field("directional", directional);
+    ar.field("angle", angle);
+}
+
+void BlurNode::adoptResults(const BaseNode& evaluated) {
+    BaseNode::adoptResults(evaluated);
+    const auto& result = static_cast<const BlurNode&>(evaluated);
+    directionalKernel = result.directionalKernel;
+    kernelRadius = result.kernelRadius;
+    kernelAngle = result.kernelAngle;
+}
+
+void BlurNode::prepareDirectionalKernel(int r) {
+    if(r == kernelRadius && angle == kernelAngle && !directionalKernel.empty()) return;
+
+    // 1. Creating a Gaussian kernel
+    cv::Mat kernel = cv::getGaussianKernel(r*2+1, -1);
+
+    // 2. Converting to 2D kernel by multiplying with its transpose
+    cv::Mat kernelX = kernel * kernel.t();
+
+    // 3. Rotating the kernel according to the specified angle
+    cv::warpAffine(kernelX, kernelX,
+        cv::getRotationMatrix2D(cv::Point2f(r, r), angle, 1.0),
+        kernelX.size());
+
+    // 4. Factoring it, so that a kernel that is still separable after the
+    // rotation runs as two 1-D passes
+    directionalKernel = FilterKernel(kernelX);
+    kernelRadius = r;
+    kernelAngle = angle;
+}
+
 /**
  * @brief Processes the input image with blur effect
  * Applies either standard Gaussian blur or directional blur based on settings
@@ -34,27 +73,33 @@ int BlurNode::getPinType(int pinId) const {
  */
 void BlurNode::process() {
     if(inputs[0].data.empty()) return;  // Skip processing if no input image
-    
+    blur(inputs[0].data, outputs[0].data);
+}
+
+void BlurNode::processGpu() {
+    if(inputs[0].gpu.empty()) return;
+    blur(inputs[0].gpu, outputs[0].gpu);
+}
+
+// Shared by both backends: Image is cv::Mat on the CPU, cv::UMat on the GPU
+template <typename Image>
+void BlurNode::blur(const Image& input, Image& output) {
+    // The radius is given at full resolution; a proxy may scale it down to nothing
+    const int r = proxyPixels(radius, 0);
+    if(r == 0) {
+        output = input;
+        return;
+    }
     if(directional) {
-        // Create and apply a directional blur effect by:
-        // 1. Creating a Gaussian kernel
-        cv::Mat kernel = cv::getGaussianKernel(radius*2+1, -1);
-        
-        // 2. Converting to 2D kernel by multiplying with its transpose
-        cv::Mat kernelX = kernel * kernel.t();
-        
-        // 3. Rotating the kernel according to the specified angle
-        cv::warpAffine(kernelX, kernelX, 
-            cv::getRotationMatrix2D(cv::Point2f(radius, radius), angle, 1.0), 
-            kernelX.size());
-            
-        // 4. Applying the rotated kernel as a custom filter
-        cv::filter2D(inputs[0].data, outputs[0].data, -1, kernelX);
+        // Apply the rotated kernel as a custom filter; it is only rebuilt
+        // when the radius or angle changes
+        prepareDirectionalKernel(r);
+        directionalKernel.apply(input, output, cv::BORDER_DEFAULT);
     } else {
         // Apply standard Gaussian blur with specified radius
         // Kernel size is calculated as 2*radius+1 to ensure odd dimensions
-        cv::GaussianBlur(inputs[0].data, outputs[0].data, 
-                        cv::Size(radius*2+1, radius*2+1), 0);
+        cv::GaussianBlur(input, output, 
+                        cv::Size(r*2+1, r*2+1), 0);
     }
 }
 
@@ -63,11 +108,11 @@ void BlurNode::process() {
  * Provides sliders and checkbox for interactive parameter adjustment
  */
 void BlurNode::drawUI() {
-    ImGui::SliderInt("Radius", &radius, 1, 20);  // Control blur strength/kernel size
-    ImGui::Checkbox("Directional", &directional); // Toggle between standard and directional blur
+    dirty |= ImGui::SliderInt("Radius", &radius, 1, 20);  // Control blur strength/kernel size
+    dirty |= ImGui::Checkbox("Directional", &directional); // Toggle between standard and directional blur
     
     // Only show angle control when directional blur is enabled
     if(directional) {
-        ImGui::SliderFloat("Angle", &angle, 0.0f, 360.0f); // Control blur direction angle
+        dirty |= ImGui::SliderFloat("Angle", &angle, 0.0f, 360.0f); // Control blur direction angle
     }
 }
@@ -12,25 +12,47 @@ int BrightnessContrastNode::getPinType(int pinId) const {
     return 0;
 }
 
+BaseNode* BrightnessContrastNode::clone() const {
+    return new BrightnessContrastNode(*this);
+}
+
+void BrightnessContrastNode::serializeParams(ParamArchive& ar) {
+    ar.field("brightness", brightness);
+    ar.field("contrast", contrast);
+}
+
 
 void BrightnessContrastNode::process() {
     if (inputs.empty() || inputs[0].data.empty()) {
         return;
     }
-    // Create a copy of the input image
-    cv::Mat output = inputs[0].data.clone();
-    // Apply brightness and contrast
-    output.convertTo(output, -1, contrast, brightness);
+    // Apply brightness and contrast straight from the shared input buffer,
+    // at its own depth; brightness is in 8-bit steps whatever the depth
+    const cv::Mat& input = inputs[0].data;
+    cv::Mat output;
+    input.convertTo(output, -1, contrast, brightness * depthMax(input.depth()) / 255.0);
 
     outputs[0].data = output;
 }
 
+bool BrightnessContrastNode::pointwiseLut(int channels, cv::Mat& lut, bool& toGray) const {
+    // Same saturating scale and offset as convertTo(), per byte value
+    lut.create(1, 256, CV_8U);
+    unsigned char* table = lut.ptr<unsigned char>();
+    for (int i = 0; i < 256; i++) {
+        table[i] = cv::saturate_cast<unsigned char>(i * contrast + brightness);
+    }
+    toGray = false;
+    return true;
+}
+
 
 void BrightnessContrastNode::drawUI() {
-    ImGui::SliderFloat("Brightness", &brightness, -100.0f, 100.0f);
-    ImGui::SliderFloat("Contrast", &contrast, 0.0f, 3.0f);
+    dirty |= ImGui::SliderFloat("Brightness", &brightness, -100.0f, 100.0f);
+    dirty |= ImGui::SliderFloat("Contrast", &contrast, 0.0f, 3.0f);
     if(ImGui::Button("Reset")) {
         brightness = 0.0f;
         contrast = 1.0f;
+        dirty = true;
     }
 }
@@ -27,6 +27,14 @@ int ColorChannelSplitterNode::getPinType(int pinId) const {
     return 0;
 }
 
+BaseNode* ColorChannelSplitterNode::clone() const {
+    return new ColorChannelSplitterNode(*this);
+}
+
+void ColorChannelSplitterNode::serializeParams(ParamArchive& ar) {
+    ar.field("grayscaleOutput", grayscaleOutput);
+}
+
 /**
  * Processes the input image by splitting it into individual channels
  * 
@@ -41,21 +49,12 @@ void ColorChannelSplitterNode::process() {
     std::vector<cv::Mat> channels;
     cv::split(inputs[0].data, channels);
     
-    // Process each channel and assign to the corresponding output pin
+    // Each channel goes out as a grayscale image. In colorized mode the pin
+    // is marked as standing for a color image with only that channel set
+    // (see outputColorChannel), and the zero-filled image is made only for
+    // consumers and previews that need it.
     for(size_t i = 0; i < outputs.size() && i < channels.size(); ++i) {
-        if(grayscaleOutput) {
-            // Option 1: Output each channel as a grayscale image
-            outputs[i].data = channels[i];
-        } else {
-            // Option 2: Output each channel as a colorized image
-            // Create an empty 3-channel (color) image filled with zeros
-            cv::Mat color(inputs[0].data.size(), CV_8UC3, cv::Scalar(0));
-            
-            // Place the channel data in the appropriate color channel of the output
-            // For example: channel 0 (red) goes into the red channel of the color image
-            cv::mixChannels({channels[i]}, {color}, {0, static_cast<int>(i)});
-            outputs[i].data = color;
-        }
+        outputs[i].data = channels[i];
     }
 }
 
@@ -65,5 +64,5 @@ void ColorChannelSplitterNode::process() {
  * Provides a checkbox to toggle between grayscale and colorized output modes
  */
 void ColorChannelSplitterNode::drawUI() {
-    ImGui::Checkbox("Grayscale Output", &grayscaleOutput);  // Toggle between output modes
+    dirty |= ImGui::Checkbox("Grayscale Output", &grayscaleOutput);  // Toggle between output modes
 }
@@ -1,6 +1,8 @@
 #include "nodes/ConvolutionNode.hpp"
 #include <imgui.h>
 #include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 ConvolutionNode::ConvolutionNode() {
@@ -19,42 +21,128 @@ int ConvolutionNode::getPinType(int pinId) const {
     return 0;
 }
 
-void ConvolutionNode::process() {
-    if (inputs.empty() || inputs[0].data.empty()) {
-        outputs[0].data.release();
-        return;
-    }
+BaseNode* ConvolutionNode::clone() const {
+    return new ConvolutionNode(*this);
+}
 
-    // Validate and prepare input
-    cv::Mat input = inputs[0].data.clone();
-    if (input.channels() == 4) {
-        cv::cvtColor(input, input, cv::COLOR_BGRA2BGR);
+void ConvolutionNode::serializeParams(ParamArchive& ar) {
+    int size = kernelSize;
+    int preset = currentPreset;
+    ar.field("kernelSize", size);
+    ar.field("preset", preset);
+    ar.field("kernelScale", kernelScale);
+
+    // Kernel is stored row-major as a flat list
+    std::vector<float> flat;
+    if (!ar.loading()) {
+        for (const auto& row : kernel) {
+            flat.insert(flat.end(), row.begin(), row.end());
+        }
     }
+    ar.field("kernel", flat);
+    if (!ar.loading()) return;
 
-    // Create and validate kernel matrix
-    cv::Mat kernelMat(kernelSize, kernelSize, CV_32F);
-    try {
+    updateKernelSize(size);
+    currentPreset = static_cast<FilterPreset>(preset);
+    if (flat.size() == static_cast<size_t>(kernelSize * kernelSize)) {
         for (int i = 0; i < kernelSize; i++) {
             for (int j = 0; j < kernelSize; j++) {
-                kernelMat.at<float>(i, j) = kernel[i][j] * kernelScale;
+                kernel[i][j] = flat[i * kernelSize + j];
             }
         }
-    } catch (const std::exception& e) {
-        std::cerr << "Kernel access error: " << e.what() << std::endl;
+    } else if (currentPreset != PRESET_CUSTOM) {
+        float scale = kernelScale;
+        loadPreset(currentPreset);
+        kernelScale = scale;
+    }
+}
+
+void ConvolutionNode::adoptResults(const BaseNode& evaluated) {
+    BaseNode::adoptResults(evaluated);
+    // Kept for the next snapshot; prepareFilter() rebuilds them if the kernel was edited since
+    filters = static_cast<const ConvolutionNode&>(evaluated).filters;
+}
+
+cv::Mat ConvolutionNode::scaledKernel() const {
+    cv::Mat kernelMat(kernelSize, kernelSize, CV_32F);
+    for (int i = 0; i < kernelSize; i++) {
+        for (int j = 0; j < kernelSize; j++) {
+            kernelMat.at<float>(i, j) = kernel[i][j] * kernelScale;
+        }
+    }
+
+    // Proxies shrink the kernel with the image so it covers the same area
+    const int size = proxyPixels(kernelSize, 3) | 1;
+    if (size >= kernelSize) return kernelMat;
+
+    const double sum = cv::sum(kernelMat)[0];
+    cv::Mat resized;
+    cv::resize(kernelMat, resized, cv::Size(size, size), 0, 0, cv::INTER_AREA);
+    // INTER_AREA averages, so the weights are scaled back up to the same total
+    // response; zero-sum kernels (edges, emboss) are kept at zero
+    resized *= static_cast<double>(kernelSize * kernelSize) / (size * size);
+    const double resizedSum = cv::sum(resized)[0];
+    if (std::abs(sum) > 1e-6 && std::abs(resizedSum) > 1e-6) {
+        resized *= sum / resizedSum;
+    } else {
+        resized -= resizedSum / (size * size);
+    }
+    return resized;
+}
+
+FilterKernel& ConvolutionNode::prepareFilter() {
+    const uint64_t key = paramHash();
+    auto entry = std::find_if(filters.begin(), filters.end(),
+                              [&](const ScaledFilter& f) { return f.scale == proxyScale; });
+    if (entry == filters.end()) {
+        filters.push_back(ScaledFilter{proxyScale, 0, FilterKernel()});
+        entry = filters.end() - 1;
+    }
+    if (entry->filter.empty() || entry->key != key) {
+        entry->filter = FilterKernel(scaledKernel());
+        entry->key = key;
+    }
+    return entry->filter;
+}
+
+void ConvolutionNode::process() {
+    if (inputs.empty() || inputs[0].data.empty()) {
+        outputs[0].data.release();
         return;
     }
+    convolve(inputs[0].data, outputs[0].data, prepareFilter());
+}
 
-    // Apply convolution with safety checks
-    cv::Mat output;
+void ConvolutionNode::processGpu() {
+    if (inputs.empty() || inputs[0].gpu.empty()) {
+        outputs[0].gpu.release();
+        return;
+    }
+    convolve(inputs[0].gpu, outputs[0].gpu, prepareFilter());
+}
+
+// One implementation for cv::Mat (process) and cv::UMat (processGpu)
+template <typename Image>
+void ConvolutionNode::convolve(const Image& source, Image& result, FilterKernel& filter) {
+    // Validate and prepare input (shared, read-only unless a conversion is needed)
+    Image input = source;
+    if (input.channels() == 4) {
+        Image bgr;
+        cv::cvtColor(input, bgr, cv::COLOR_BGRA2BGR);
+        input = bgr;
+    }
+
+    // Apply convolution with safety checks; separable and large kernels
+    // take the faster paths of FilterKernel
+    Image output;
     try {
-        cv::filter2D(input, output, -1, kernelMat, 
-                    cv::Point(-1,-1), 0, cv::BORDER_REPLICATE);
+        filter.apply(input, output, cv::BORDER_REPLICATE);
     } catch (const cv::Exception& e) {
         std::cerr << "Convolution failed: " << e.what() << std::endl;
         return;
     }
 
-    outputs[0].data = output;
+    result = output;
 }
 
 void ConvolutionNode::drawUI() {
@@ -63,21 +151,36 @@ void ConvolutionNode::drawUI() {
                             "Sharpen", "Emboss", "Blur"};
     if (ImGui::Combo("Preset", (int*)&currentPreset, presets, PRESET_COUNT)) {
         loadPreset(currentPreset);
+        dirty = true;
     }
 
     // Kernel size control
     int newSize = kernelSize;
-    if (ImGui::SliderInt("Kernel Size", &newSize, 3, 9)) {
+    if (ImGui::SliderInt("Kernel Size", &newSize, 3, kMaxKernelSize)) {
         updateKernelSize(newSize);
         if (currentPreset != PRESET_CUSTOM) {
             loadPreset(currentPreset);
         }
+        dirty = true;
     }
 
     // Kernel scale
-    ImGui::SliderFloat("Scale", &kernelScale, 0.1f, 2.0f, "%.2f");
+    dirty |= ImGui::SliderFloat("Scale", &kernelScale, 0.1f, 2.0f, "%.2f");
+
+    // How the last full-size evaluation applied the kernel
+    auto full = std::find_if(filters.begin(), filters.end(),
+                             [](const ScaledFilter& f) { return f.scale == 1.0; });
+    if (full != filters.end() && !full->filter.empty()) {
+        const FilterKernel& filter = full->filter;
+        ImGui::TextDisabled("%s", filter.separable() ? "Separable (two 1-D passes)" :
+                            filter.size() >= FilterKernel::kDftMinSize ? "Applied through the DFT" : "Dense");
+    }
 
     // Kernel matrix editor
+    if (kernelSize > kMaxEditableSize) {
+        ImGui::Text("%dx%d kernel; pick a preset or load it from a graph file", kernelSize, kernelSize);
+        return;
+    }
     ImGui::Text("Kernel Matrix:");
     ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(2, 2));
     for (int i = 0; i < kernelSize; i++) {
@@ -87,6 +190,7 @@ void ConvolutionNode::drawUI() {
             ImGui::PushItemWidth(50);
             if (ImGui::InputFloat("", &kernel[i][j], 0, 0, "%.2f")) {
                 currentPreset = PRESET_CUSTOM;
+                dirty = true;
             }
             ImGui::PopItemWidth();
         }
@@ -96,8 +200,8 @@ void ConvolutionNode::drawUI() {
 }
 
 void ConvolutionNode::updateKernelSize(int newSize) {
-    // Ensure odd size between 3 and 9
-    kernelSize = std::max(3, std::min(9, newSize));
+    // Ensure odd size between 3 and kMaxKernelSize
+    kernelSize = std::max(3, std::min(kMaxKernelSize, newSize));
     if (kernelSize % 2 == 0) {
         kernelSize++;
     }
@@ -37,22 +37,53 @@ int EdgeDetectionNode::getPinType(int pinId) const {
     return 0; // All pins are image type
 }
 
+BaseNode* EdgeDetectionNode::clone() const {
+    return new EdgeDetectionNode(*this);
+}
+
+void EdgeDetectionNode::serializeParams(ParamArchive& ar) {
+    ar.field("method", method);
+    ar.field("threshold1", threshold1);
+    ar.field("threshold2", threshold2);
+    ar.field("kernelSize", kernelSize);
+    ar.field("overlay", overlay);
+}
+
+int EdgeDetectionNode::tileHalo() const {
+    // Canny's hysteresis follows edges across the whole image
+    if (method == 1) return -1;
+    // Sobel/Laplacian with ksize 1 still use a 3-pixel aperture
+    int validKernelSize = (kernelSize % 2 == 0) ? kernelSize + 1 : kernelSize;
+    return std::max(1, validKernelSize / 2);
+}
+
 void EdgeDetectionNode::process() {
     if (inputs.empty() || inputs[0].data.empty()) {
         return;
     }
+    detectEdges(inputs[0].data, inputs[0].gray(), outputs[0].data);
+}
 
-    // Get input image
-    cv::Mat inputImage = inputs[0].data.clone();
-    cv::Mat edges, outputImage;
-    
-    // Convert to grayscale if it's color
-    cv::Mat grayImage;
-    if (inputImage.channels() == 3) {
-        cv::cvtColor(inputImage, grayImage, cv::COLOR_BGR2GRAY);
-    } else {
-        grayImage = inputImage.clone();
+void EdgeDetectionNode::processGpu() {
+    if (inputs.empty() || inputs[0].gpu.empty()) {
+        return;
     }
+    cv::UMat gray = inputs[0].gpu;
+    if (gray.channels() == 3) cv::cvtColor(inputs[0].gpu, gray, cv::COLOR_BGR2GRAY);
+    detectEdges(inputs[0].gpu, gray, outputs[0].gpu);
+}
+
+// The same steps for host and device images; grayImage is inputImage
+// reduced to one channel, which host callers share with other consumers.
+// The operators and their thresholds work on 8 bits, so deeper images are
+// detected on an 8-bit copy and the edges returned at the input's depth.
+template <typename Image>
+void EdgeDetectionNode::detectEdges(const Image& inputImage, const Image& grayIn, Image& result) const {
+    const int depth = inputImage.depth();
+    Image grayImage = grayIn;
+    if (depth != CV_8U) grayIn.convertTo(grayImage, CV_8U, 255.0 / depthMax(depth));
+
+    Image edges, outputImage;
 
     // Apply edge detection based on selected method
     switch (method) {
@@ -66,7 +97,7 @@ void EdgeDetectionNode::process() {
             validKernelSize = std::min(7, std::max(1, validKernelSize));
             
             // Calculate gradients
-            cv::Mat gradX, gradY, absGradX, absGradY;
+            Image gradX, gradY, absGradX, absGradY;
             cv::Sobel(grayImage, gradX, CV_16S, 1, 0, validKernelSize);
             cv::Sobel(grayImage, gradY, CV_16S, 0, 1, validKernelSize);
             
@@ -96,6 +127,12 @@ void EdgeDetectionNode::process() {
         }
     }
 
+    if (depth != CV_8U) {
+        Image deep;
+        edges.convertTo(deep, depth, depthMax(depth) / 255.0);
+        edges = deep;
+    }
+
     // Create output image
     if (overlay && inputImage.channels() == 3) {
         // Convert edges to color for overlay
@@ -107,16 +144,16 @@ void EdgeDetectionNode::process() {
         // For grayscale, just blend directly
         cv::addWeighted(inputImage, 0.7, edges, 0.3, 0, outputImage);
     } else {
-        outputImage = edges.clone();
+        outputImage = edges;
     }
 
-    outputs[0].data = outputImage;
+    result = outputImage;
 }
 
 void EdgeDetectionNode::drawUI() {
     // Edge detection method
     const char* methods[] = {"Sobel", "Canny", "Laplacian"};
-    ImGui::Combo("Method", &method, methods, IM_ARRAYSIZE(methods));
+    dirty |= ImGui::Combo("Method", &method, methods, IM_ARRAYSIZE(methods));
     
     // Parameters for each method
     if (method == 0) { // Sobel
@@ -137,11 +174,12 @@ void EdgeDetectionNode::drawUI() {
             else if (kernelIndex == 1) kernelSize = 3;
             else if (kernelIndex == 2) kernelSize = 5;
             else if (kernelIndex == 3) kernelSize = 7;
+            dirty = true;
         }
     } 
     else if (method == 1) { // Canny
-        ImGui::SliderFloat("Threshold 1", &threshold1, 0.0f, 300.0f);
-        ImGui::SliderFloat("Threshold 2", &threshold2, 0.0f, 300.0f);
+        dirty |= ImGui::SliderFloat("Threshold 1", &threshold1, 0.0f, 300.0f);
+        dirty |= ImGui::SliderFloat("Threshold 2", &threshold2, 0.0f, 300.0f);
         
         const char* kernelSizes[] = {"3x3", "5x5", "7x7"};
         int kernelIndex = 0;
@@ -158,6 +196,7 @@ void EdgeDetectionNode::drawUI() {
             if (kernelIndex == 0) kernelSize = 3;
             else if (kernelIndex == 1) kernelSize = 5;
             else if (kernelIndex == 2) kernelSize = 7;
+            dirty = true;
         }
     }
     else if (method == 2) { // Laplacian
@@ -176,8 +215,9 @@ void EdgeDetectionNode::drawUI() {
         if (ImGui::Combo("Kernel Size", &kernelIndex, kernelSizes, IM_ARRAYSIZE(kernelSizes))) {
             // Convert index back to kernel size
             kernelSize = 1 + kernelIndex * 2; // Generates 1, 3, 5, 7, 9, 11
+            dirty = true;
         }
     }
      // Overlay checkbox - toggle between showing just edges or edges on original image
-    ImGui::Checkbox("Overlay on Original", &overlay);
+    dirty |= ImGui::Checkbox("Overlay on Original", &overlay);
 }
@@ -5,7 +5,12 @@
 #include "portable-file-dialogs.h" // Include cross-platform file dialog library
 
 #include "ImageInputNode.hpp"
+#include "ResultCache.hpp"
 #include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cstring>
+#include <functional>
 
 /**
  * Constructor for ImageInputNode
@@ -26,11 +31,108 @@ int ImageInputNode::getPinType(int pinId) const {
     return 0; // Assuming all pins are image type
 }
 
+BaseNode* ImageInputNode::clone() const {
+    return new ImageInputNode(*this);
+}
+
+void ImageInputNode::serializeParams(ParamArchive& ar) {
+    ar.field("filepath", filepath);
+    ar.field("mode", mode);
+    ar.field("sequence", sequencePath);
+    ar.field("frame", frame);
+    ar.field("fps", playbackFps);
+}
+
+void ImageInputNode::adoptResults(const BaseNode& evaluated) {
+    BaseNode::adoptResults(evaluated);
+    const auto& result = static_cast<const ImageInputNode&>(evaluated);
+    originalImage = result.originalImage;
+    loadedStamp = result.loadedStamp;
+    working = result.working;
+    workingSource = result.workingSource;
+    proxy = result.proxy;
+    proxySource = result.proxySource;
+    proxyBuiltScale = result.proxyBuiltScale;
+    sequence = result.sequence;
+    loadedFrame = result.loadedFrame;
+}
+
 void ImageInputNode::process() {
-    if(!filepath.empty()) {
-        originalImage = cv::imread(filepath);
-        outputs[0].data = originalImage.clone();
+    if(mode == MODE_SEQUENCE) {
+        if(!sequencePath.empty() && (!sequence || sequence->source() != sequencePath)) {
+            auto opened = std::make_shared<FramePrefetcher>();
+            opened->open(sequencePath);
+            sequence = opened;
+        }
+        // Usually decoded ahead already; scrubbing to a far frame waits for it here
+        originalImage = sequence && !sequencePath.empty() ? sequence->frame(frame) : cv::Mat();
+        loadedFrame = frame;
+    } else if(!filepath.empty()) {
+        // Decoded at most once per file version; repeated loads are cache hits
+        originalImage = ImageCache::instance().load(filepath, &loadedStamp);
+    }
+    const cv::Mat& image = workingImage();
+    outputs[0].data = proxyScale < 1.0 && !image.empty() ? proxyImage(image) : image;
+}
+
+// The decoded file version or sequence frame, at the working depth and
+// proxy scale, fixes the output; switching between proxy and full passes
+// therefore returns to the same versions. Images handed in through
+// setImage() have no such identity.
+uint64_t ImageInputNode::outputVersion(size_t) const {
+    if (originalImage.empty()) return 0;
+    uint64_t version = 0;
+    if (mode == MODE_SEQUENCE) {
+        version = ResultCache::combine(std::hash<std::string>()(sequencePath), static_cast<uint64_t>(loadedFrame));
+    } else if (!filepath.empty() && loadedStamp != ImageCache::Stamp()) {
+        version = ResultCache::combine(std::hash<std::string>()(filepath), static_cast<uint64_t>(loadedStamp.mtime));
+        version = ResultCache::combine(version, static_cast<uint64_t>(loadedStamp.size));
+    } else {
+        return 0;
+    }
+    uint64_t scaleBits = 0;
+    std::memcpy(&scaleBits, &proxyScale, sizeof(scaleBits));
+    version = ResultCache::combine(version, static_cast<uint64_t>(workingDepth));
+    version = ResultCache::combine(version, scaleBits);
+    return version ? version : 1;
+}
+
+// Files decode at their own depth; the graph sees them at the working depth
+const cv::Mat& ImageInputNode::workingImage() {
+    if (originalImage.empty() || originalImage.depth() == workingDepth) return originalImage;
+    if (working.empty() || working.depth() != workingDepth ||
+        workingSource.data != originalImage.data || workingSource.size() != originalImage.size()) {
+        working = convertDepth(originalImage, workingDepth);
+        workingSource = originalImage;
+    }
+    return working;
+}
+
+const cv::Mat& ImageInputNode::proxyImage(const cv::Mat& source) {
+    if (proxy.empty() || proxySource.data != source.data ||
+        proxySource.size() != source.size() || proxyBuiltScale != proxyScale) {
+        cv::Size size(std::max(1, static_cast<int>(std::lround(source.cols * proxyScale))),
+                      std::max(1, static_cast<int>(std::lround(source.rows * proxyScale))));
+        // A new buffer every time: the previous proxy may still be read downstream
+        cv::Mat scaled;
+        cv::resize(source, scaled, size, 0, 0, cv::INTER_AREA);
+        proxy = scaled;
+        proxySource = source;
+        proxyBuiltScale = proxyScale;
     }
+    return proxy;
+}
+
+/**
+ * Feeds an already decoded image into the graph instead of a file path.
+ * Used by the batch runner, which decodes frames ahead on its own thread.
+ */
+void ImageInputNode::setImage(const cv::Mat& image) {
+    mode = MODE_IMAGE;
+    filepath.clear();
+    loadedStamp = ImageCache::Stamp();
+    originalImage = image;
+    dirty = true;
 }
 
 /**
@@ -40,14 +142,104 @@ void ImageInputNode::process() {
 
 void ImageInputNode::drawUI() {
     ImGui::Text("Image Input");
+    const char* modes[] = {"Image", "Sequence / Video"};
+    dirty |= ImGui::Combo("Source", &mode, modes, IM_ARRAYSIZE(modes));
+    if(mode == MODE_SEQUENCE) {
+        drawTimeline();
+        return;
+    }
+
     if(ImGui::Button("Load Image")) {
-        auto file = pfd::open_file("Select image", ".", {"Image Files", "*.png *.jpg *.jpeg *.bmp"});
+        auto file = pfd::open_file("Select image", ".", {"Image Files", "*.png *.jpg *.jpeg *.bmp *.tif *.tiff *.exr"});
         // If a file was selected (result is not empty)
         if(!file.result().empty()) {
             filepath = file.result()[0];
-            process();
+            dirty = true; // Decoded on the next processGraph() pass
         }
     }
     // Display the current filepath in the UI
     ImGui::Text("%s", filepath.c_str());
+
+    // Pick up edits made to the file on disk since it was decoded, checked
+    // every kStampPollInterval rather than every frame. The stamp is updated
+    // right away so one change triggers exactly one re-evaluation.
+    const double now = ImGui::GetTime();
+    if(!filepath.empty() && !originalImage.empty() && now >= nextStampCheck) {
+        nextStampCheck = now + kStampPollInterval;
+        ImageCache::Stamp current;
+        if(ImageCache::readStamp(filepath, current) && current != loadedStamp) {
+            loadedStamp = current;
+            dirty = true;
+        }
+    }
+}
+
+// Playback steps inside drawTimeline(), so a playing sequence needs a frame
+// when its next step is due. Until the current frame's evaluation is in or
+// the next frame is decoded, those wake the editor instead. In image mode
+// the frame is due for the next check of the file.
+double ImageInputNode::redrawIn(double now) const {
+    // A loaded file is polled for changes by drawUI()
+    if (mode == MODE_IMAGE) {
+        return !filepath.empty() && !originalImage.empty() ? std::max(0.0, nextStampCheck - now) : -1.0;
+    }
+    if (!playing || !sequence || sequence->frameCount() <= 0) return -1.0;
+    const double rate = playbackFps > 0.0f ? playbackFps : sequence->fps();
+    if (rate <= 0.0 || loadedFrame != frame || dirty) return -1.0;
+    const int next = frame < sequence->frameCount() - 1 ? frame + 1 : 0;
+    if (!sequence->ready(next)) return -1.0;
+    return std::max(0.0, lastAdvance + 1.0 / rate - now);
+}
+
+/**
+ * Sequence source selection and the timeline: a frame slider for scrubbing
+ * and play/pause. Playback steps to the next frame only once the current
+ * one has been evaluated and the next one is decoded, so a graph slower
+ * than the frame rate plays every frame at its own pace instead of having
+ * each evaluation cancelled by the next frame.
+ */
+void ImageInputNode::drawTimeline() {
+    if(ImGui::Button("Open Sequence")) {
+        auto file = pfd::open_file("Select a video or one frame of a numbered sequence", ".",
+            {"Video and image files", "*.mp4 *.mov *.avi *.mkv *.webm *.png *.jpg *.jpeg *.tif *.tiff *.exr"});
+        if(!file.result().empty()) {
+            sequencePath = FramePrefetcher::patternFor(file.result()[0]);
+            frame = 0;
+            playing = false;
+            dirty = true;
+        }
+    }
+    ImGui::Text("%s", sequencePath.c_str());
+
+    if(!sequence || sequence->source() != sequencePath || sequence->frameCount() <= 0) {
+        if(!sequencePath.empty()) ImGui::TextDisabled("Opening...");
+        return;
+    }
+
+    const int last = sequence->frameCount() - 1;
+    if(ImGui::SliderInt("Frame", &frame, 0, last)) {
+        frame = std::max(0, std::min(frame, last));
+        dirty = true;
+    }
+    if(ImGui::Button(playing ? "Pause" : "Play")) {
+        playing = !playing;
+        lastAdvance = ImGui::GetTime();
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120);
+    // Playback timing only; the pixels do not change
+    ImGui::SliderFloat("FPS", &playbackFps, 0.0f, 120.0f, playbackFps > 0.0f ? "%.1f" : "source");
+
+    const double rate = playbackFps > 0.0f ? playbackFps : sequence->fps();
+    ImGui::TextDisabled("%d frames, %.2f fps", last + 1, sequence->fps());
+    if(!playing || rate <= 0.0) return;
+
+    const int next = frame < last ? frame + 1 : 0;
+    const double now = ImGui::GetTime();
+    if(loadedFrame == frame && !dirty && now - lastAdvance >= 1.0 / rate && sequence->ready(next)) {
+        frame = next;
+        dirty = true;
+        // Keeps the cadence when a step was late, without trying to catch up
+        lastAdvance = std::max(lastAdvance + 1.0 / rate, now - 1.0 / rate);
+    }
 }
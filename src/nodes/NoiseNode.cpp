@@ -3,7 +3,129 @@
 #include <imgui.h>
 #include <opencv2/opencv.hpp>
 #include <vector>
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace {
+
+// Perlin lattice: a permutation of 0..255 stored twice, so perm[p + y] needs
+// no wrap for p, y < kSize, and one unit gradient per permutation value.
+// The permutation is shuffled with cellHash() and identical on every platform.
+struct Lattice {
+    static constexpr int kSize = 256;
+    static constexpr int kMask = kSize - 1;
+    int perm[2 * kSize];
+    float gradX[kSize];
+    float gradY[kSize];
+
+    Lattice();
+};
+
+const Lattice& lattice() {
+    static const Lattice table;
+    return table;
+}
+
+inline float fade(float t) {
+    return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+inline float toUnit(float value) {
+    return std::min(std::max(value, 0.0f), 1.0f);
+}
+
+// Integer mix of a grid cell and seed; identical on every platform
+inline uint32_t cellHash(int cx, int cy, uint32_t seed) {
+    uint32_t h = static_cast<uint32_t>(cx) * 0x8da6b343u ^ static_cast<uint32_t>(cy) * 0xd8163841u ^
+                 seed * 0xcb1ab31fu;
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return h;
+}
+
+inline float unitFloat(uint32_t h) {
+    return (h >> 8) * (1.0f / 16777216.0f);
+}
+
+Lattice::Lattice() {
+    for (int k = 0; k < kSize; k++) perm[k] = k;
+    for (int k = kSize - 1; k > 0; k--) {
+        std::swap(perm[k], perm[cellHash(k, 0, 0x2545f491u) % (k + 1)]);
+    }
+    for (int k = 0; k < kSize; k++) {
+        perm[kSize + k] = perm[k];
+        float angle = k * (6.28318531f / kSize);
+        gradX[k] = std::cos(angle);
+        gradY[k] = std::sin(angle);
+    }
+}
+
+// One octave of the (radial falloff) simplex noise for a row of samples,
+// added to total. Branch-free so the loop vectorizes; every coordinate is
+// non-negative, so truncation is floor.
+void addSimplexRow(const float* xs, float y, int count, float amplitude, float* total) {
+    const float F2 = 0.366025403f; // 0.5*(sqrt(3.0)-1.0)
+    const float G2 = 0.211324865f; // (3.0-sqrt(3.0))/6.0
+    auto corner = [](float x, float y) {
+        float d = x * x + y * y;
+        float t = std::max(0.5f - d, 0.0f);
+        t *= t;
+        return t * t * d;
+    };
+    
+    for (int k = 0; k < count; k++) {
+        // Skew input space to determine which simplex cell we're in
+        float x = xs[k];
+        float s = (x + y) * F2;
+        int i = static_cast<int>(x + s);
+        int j = static_cast<int>(y + s);
+        float t = static_cast<float>(i + j) * G2;
+        float x0 = x - (i - t);
+        float y0 = y - (j - t);
+        
+        // Lower or upper triangle of the cell
+        float i1 = x0 > y0 ? 1.0f : 0.0f;
+        float j1 = 1.0f - i1;
+        float x1 = x0 - i1 + G2;
+        float y1 = y0 - j1 + G2;
+        float x2 = x0 - 1.0f + 2.0f * G2;
+        float y2 = y0 - 1.0f + 2.0f * G2;
+        
+        // Scaled to [-1,1]
+        total[k] += 70.0f * (corner(x0, y0) + corner(x1, y1) + corner(x2, y2)) * amplitude;
+    }
+}
+
+// Lattice offset between the channels of a multi-channel map, in cells.
+// Whole cells keep the fractional positions and only change the hashes.
+constexpr int kChannelOffsetX = 37;
+constexpr int kChannelOffsetY = 71;
+
+// Per-octave frequency and weight, accumulated the same way as before
+struct Octaves {
+    std::vector<float> frequency;
+    std::vector<float> amplitude;
+    float total = 0.0f;
+
+    Octaves(int count, float persistence) {
+        float f = 1.0f;
+        float a = 1.0f;
+        for (int o = 0; o < count; o++) {
+            frequency.push_back(f);
+            amplitude.push_back(a);
+            total += a;
+            a *= persistence;
+            f *= 2.0f;
+        }
+    }
+};
+
+} // namespace
 
 NoiseNode::NoiseNode() {
     name = "Noise Generator";
@@ -12,10 +134,6 @@ NoiseNode::NoiseNode() {
     // Add output pin for noise
     outputs.emplace_back(Pin{1, "Noise"});
     
-    // Initialize RNG with random seed
-    std::random_device rd;
-    rng = std::mt19937(rd());
-    
     // Default to Worley noise (as seen in screenshot)
     noiseType = 2;
 }
@@ -24,318 +142,336 @@ int NoiseNode::getPinType(int pinId) const {
     return 0; // All pins are image type
 }
 
+BaseNode* NoiseNode::clone() const {
+    return new NoiseNode(*this);
+}
+
+void NoiseNode::serializeParams(ParamArchive& ar) {
+    ar.field("noiseType", noiseType);
+    ar.field("scale", scale);
+    ar.field("octaves", octaves);
+    ar.field("persistence", persistence);
+    ar.field("outputMode", outputMode);
+    ar.field("width", width);
+    ar.field("height", height);
+    ar.field("seed", seed);
+    ar.field("worleyDistance", worleyDistance);
+}
+
 void NoiseNode::process() {
-    cv::Mat noiseImage;
-    
-    // Generate the noise based on selected type
-    switch (noiseType) {
-        case 0: // Perlin
-            noiseImage = generatePerlinNoise(width, height);
-            break;
-        case 1: // Simplex
-            noiseImage = generateSimplexNoise(width, height);
-            break;
-        case 2: // Worley
-            noiseImage = generateWorleyNoise(width, height);
-            break;
-    }
+    // The pattern is defined relative to the image size, so a proxy only
+    // needs fewer pixels to look the same
+    const int w = proxyPixels(width);
+    const int h = proxyPixels(height);
+    cv::Mat noiseImage = generateNoise(w, h, 0);
     
     // If in displacement map mode and input image is available
     if (outputMode == 1 && !inputs[0].data.empty()) {
-        // Apply noise as displacement map
-        outputs[0].data = applyDisplacementMap(inputs[0].data, noiseImage);
+        // Apply noise as displacement map, with its own map for each axis
+        outputs[0].data = applyDisplacementMap(inputs[0].data, noiseImage, generateNoise(w, h, 1),
+                                               10.0f * static_cast<float>(proxyScale));
     } else {
-        // Direct color output
-        outputs[0].data = noiseImage;
+        // The generators work on a single channel, and so does the output;
+        // float noise is only quantized when the graph works in integers
+        outputs[0].data = convertDepth(noiseImage, workingDepth);
     }
 }
 
 void NoiseNode::drawUI() {
     // Noise type selection
     const char* noiseTypes[] = {"Perlin", "Simplex", "Worley"};
-    ImGui::Combo("Noise Type", &noiseType, noiseTypes, IM_ARRAYSIZE(noiseTypes));
+    dirty |= ImGui::Combo("Noise Type", &noiseType, noiseTypes, IM_ARRAYSIZE(noiseTypes));
     
     // Noise parameters
-    ImGui::SliderFloat("Scale", &scale, 0.001f, 5.0f);
-    ImGui::SliderInt("Octaves", &octaves, 1, 8);
-    ImGui::SliderFloat("Persistence", &persistence, 0.0f, 1.0f);
+    dirty |= ImGui::SliderFloat("Scale", &scale, 0.001f, 5.0f);
+    dirty |= ImGui::SliderInt("Octaves", &octaves, 1, 8);
+    dirty |= ImGui::SliderFloat("Persistence", &persistence, 0.0f, 1.0f);
+    
+    if (noiseType == 2) {
+        const char* distances[] = {"F1", "F2", "F2 - F1"};
+        dirty |= ImGui::Combo("Distance", &worleyDistance, distances, IM_ARRAYSIZE(distances));
+        dirty |= ImGui::InputInt("Seed", &seed);
+    }
     
     // Output resolution
-    ImGui::SliderInt("Width", &width, 128, 1024);
-    ImGui::SliderInt("Height", &height, 128, 1024);
+    dirty |= ImGui::SliderInt("Width", &width, 128, 1024);
+    dirty |= ImGui::SliderInt("Height", &height, 128, 1024);
     
     // Output mode selection
     const char* outputModes[] = {"Direct Color", "Displacement Map"};
-    ImGui::Combo("Output Mode", &outputMode, outputModes, IM_ARRAYSIZE(outputModes));
+    dirty |= ImGui::Combo("Output Mode", &outputMode, outputModes, IM_ARRAYSIZE(outputModes));
 }
 
-cv::Mat NoiseNode::generatePerlinNoise(int width, int height) {
-    cv::Mat result(height, width, CV_8UC3);
-    
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            float nx = x * scale / width;
-            float ny = y * scale / height;
-            
-            float noise = perlinNoise(nx, ny, octaves, persistence);
-            // Normalize to 0-255 range
-            unsigned char value = static_cast<unsigned char>((noise + 1.0f) * 0.5f * 255.0f);
-            
-            // Set all channels to the same value for grayscale
-            result.at<cv::Vec3b>(y, x) = cv::Vec3b(value, value, value);
-        }
+cv::Mat NoiseNode::generateNoise(int width, int height, int channel) {
+    switch (noiseType) {
+        case 0:  return generatePerlinNoise(width, height, channel);
+        case 1:  return generateSimplexNoise(width, height, channel);
+        default: return generateWorleyNoise(width, height, channel);
     }
-    
-    return result;
 }
 
-cv::Mat NoiseNode::generateSimplexNoise(int width, int height) {
-    cv::Mat result(height, width, CV_8UC3);
+cv::Mat NoiseNode::generatePerlinNoise(int width, int height, int channel) {
+    cv::Mat result(height, width, CV_32FC1);
+    if (width <= 0 || height <= 0 || octaves <= 0) return result;
+    
+    const Octaves oct(octaves, persistence);
+    const Lattice& lat = lattice();
     
-    for (int y = 0; y < height; y++) {
+    // The permutation entries of the lattice columns, the offset and the
+    // fade weight only depend on x, so they are computed once per octave
+    // instead of once per pixel
+    const size_t columns = static_cast<size_t>(width);
+    std::vector<int> permX0(columns * octaves);
+    std::vector<int> permX1(columns * octaves);
+    std::vector<float> fracX(columns * octaves);
+    std::vector<float> fadeX(columns * octaves);
+    for (int o = 0; o < octaves; o++) {
         for (int x = 0; x < width; x++) {
-            float nx = x * scale / width;
+            float nx = x * scale / width * oct.frequency[o];
+            int xi = static_cast<int>(nx);
+            size_t k = o * columns + x;
+            int cell = xi + channel * kChannelOffsetX;
+            permX0[k] = lat.perm[cell & Lattice::kMask];
+            permX1[k] = lat.perm[(cell + 1) & Lattice::kMask];
+            fracX[k] = nx - xi;
+            fadeX[k] = fade(nx - xi);
+        }
+    }
+    
+    cv::parallel_for_(cv::Range(0, height), [&](const cv::Range& rows) {
+        std::vector<float> total(columns);
+        std::vector<float> corners(columns * 4);
+        float* n00 = &corners[0];
+        float* n10 = &corners[columns];
+        float* n01 = &corners[columns * 2];
+        float* n11 = &corners[columns * 3];
+        
+        for (int y = rows.start; y < rows.end; y++) {
+            std::fill(total.begin(), total.end(), 0.0f);
             float ny = y * scale / height;
             
-            float noise = 0.0f;
-            float amplitude = 1.0f;
-            float totalAmplitude = 0.0f;
-            
-            // Accumulate octaves
+            // One octave at a time over the whole row keeps the inner loops
+            // free of branches and sequential in memory
             for (int o = 0; o < octaves; o++) {
-                float freq = std::pow(2.0f, static_cast<float>(o));
-                float noiseValue = simplexNoise(nx * freq, ny * freq);
+                float fy = ny * oct.frequency[o];
+                int yi = static_cast<int>(fy);
+                float yf = fy - yi;
+                int y0 = (yi + channel * kChannelOffsetY) & Lattice::kMask;
+                int y1 = (y0 + 1) & Lattice::kMask;
+                float v = fade(yf);
+                float amplitude = oct.amplitude[o];
+                const int* p0 = &permX0[o * columns];
+                const int* p1 = &permX1[o * columns];
+                const float* xf = &fracX[o * columns];
+                const float* u = &fadeX[o * columns];
                 
-                noise += noiseValue * amplitude;
-                totalAmplitude += amplitude;
-                amplitude *= persistence;
+                // Gradient lookups, the only gathers, in a pass of their own
+                for (int x = 0; x < width; x++) {
+                    int h00 = lat.perm[p0[x] + y0] & Lattice::kMask;
+                    int h10 = lat.perm[p1[x] + y0] & Lattice::kMask;
+                    int h01 = lat.perm[p0[x] + y1] & Lattice::kMask;
+                    int h11 = lat.perm[p1[x] + y1] & Lattice::kMask;
+                    
+                    n00[x] = lat.gradX[h00] * xf[x] + lat.gradY[h00] * yf;
+                    n10[x] = lat.gradX[h10] * (xf[x] - 1.0f) + lat.gradY[h10] * yf;
+                    n01[x] = lat.gradX[h01] * xf[x] + lat.gradY[h01] * (yf - 1.0f);
+                    n11[x] = lat.gradX[h11] * (xf[x] - 1.0f) + lat.gradY[h11] * (yf - 1.0f);
+                }
+                
+                // Interpolation over contiguous floats, which vectorizes
+                for (int x = 0; x < width; x++) {
+                    float nx0 = n00[x] + u[x] * (n10[x] - n00[x]);
+                    float nx1 = n01[x] + u[x] * (n11[x] - n01[x]);
+                    total[x] += (nx0 + v * (nx1 - nx0)) * amplitude;
+                }
             }
             
-            // Normalize by total amplitude
-            noise /= totalAmplitude;
-            
-            // Normalize to 0-255 range
-            unsigned char value = static_cast<unsigned char>((noise + 1.0f) * 0.5f * 255.0f);
-            
-            // Set all channels to the same value for grayscale
-            result.at<cv::Vec3b>(y, x) = cv::Vec3b(value, value, value);
+            // Normalize to 0-1 range
+            float* out = result.ptr<float>(y);
+            for (int x = 0; x < width; x++) {
+                out[x] = toUnit((total[x] / oct.total + 1.0f) * 0.5f);
+            }
         }
-    }
+    });
     
     return result;
 }
 
-cv::Mat NoiseNode::generateWorleyNoise(int width, int height) {
-    cv::Mat result(height, width, CV_8UC3);
+cv::Mat NoiseNode::generateSimplexNoise(int width, int height, int channel) {
+    cv::Mat result(height, width, CV_32FC1);
+    if (width <= 0 || height <= 0 || octaves <= 0) return result;
     
-    // Generate random feature points
-    const int numPoints = 20 + static_cast<int>(scale * 30);
-    std::vector<cv::Point2f> points;
+    const Octaves oct(octaves, persistence);
     
-    std::uniform_real_distribution<float> distX(0, width);
-    std::uniform_real_distribution<float> distY(0, height);
-    
-    for (int i = 0; i < numPoints; i++) {
-        points.push_back(cv::Point2f(distX(rng), distY(rng)));
+    // Sample columns of every octave, shared by all rows
+    const size_t columns = static_cast<size_t>(width);
+    std::vector<float> sampleX(columns * octaves);
+    for (int o = 0; o < octaves; o++) {
+        for (int x = 0; x < width; x++) {
+            float nx = x * scale / width;
+            sampleX[o * columns + x] = nx * oct.frequency[o] + channel * kChannelOffsetX;
+        }
     }
     
-    // Generate Worley noise
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            // Find distance to closest point
-            float minDist = std::numeric_limits<float>::max();
+    cv::parallel_for_(cv::Range(0, height), [&](const cv::Range& rows) {
+        std::vector<float> total(columns);
+        
+        for (int y = rows.start; y < rows.end; y++) {
+            std::fill(total.begin(), total.end(), 0.0f);
+            float ny = y * scale / height;
             
-            for (const auto& p : points) {
-                float dx = x - p.x;
-                float dy = y - p.y;
-                float dist = std::sqrt(dx*dx + dy*dy);
-                minDist = std::min(minDist, dist);
+            // Accumulate octaves a row at a time
+            for (int o = 0; o < octaves; o++) {
+                addSimplexRow(&sampleX[o * columns], ny * oct.frequency[o] + channel * kChannelOffsetY,
+                              width, oct.amplitude[o], total.data());
             }
             
-            // Normalize distance and apply scaling
-            float normalizedDist = minDist / (width / (scale * 10.0f));
-            normalizedDist = std::min(normalizedDist, 1.0f);
-            
-            // Apply octaves and persistence for more complex noise
-            float noise = normalizedDist;
-            float amplitude = 1.0f;
-            float totalAmplitude = 1.0f;
-            
-            for (int o = 1; o < octaves; o++) {
-                amplitude *= persistence;
-                totalAmplitude += amplitude;
-                
-                // Add variations to each octave
-                noise += normalizedDist * amplitude * (0.5f + 0.5f * std::sin(x * o * 0.01f + y * o * 0.01f));
+            // Normalize by total amplitude, then to 0-1 range
+            float* out = result.ptr<float>(y);
+            for (int x = 0; x < width; x++) {
+                out[x] = toUnit((total[x] / oct.total + 1.0f) * 0.5f);
             }
-            
-            noise /= totalAmplitude;
-            
-            // Convert to grayscale value
-            unsigned char value = static_cast<unsigned char>(noise * 255.0f);
-            
-            // Set all channels to the same value for grayscale
-            result.at<cv::Vec3b>(y, x) = cv::Vec3b(value, value, value);
         }
-    }
+    });
     
     return result;
 }
 
-// Simple implementation of Perlin noise function
-float NoiseNode::perlinNoise(float x, float y, int octaves, float persistence) {
-    float total = 0.0f;
-    float frequency = 1.0f;
-    float amplitude = 1.0f;
-    float maxValue = 0.0f;
-    
-    for (int i = 0; i < octaves; i++) {
-        // Simplified 2D gradient noise
-        int xi = static_cast<int>(x * frequency);
-        int yi = static_cast<int>(y * frequency);
-        float xf = x * frequency - xi;
-        float yf = y * frequency - yi;
-        
-        // Simple hash function
-        auto hash = [](int x, int y) {
-            int h = x * 31 + y;
-            h = h ^ (h >> 13);
-            h = h * (h * h * 15731 + 789221) + 1376312589;
-            return h & 0x7fffffff;
-        };
-        
-        // Get random gradients
-        auto getGradient = [&hash](int x, int y) {
-            int h = hash(x, y);
-            float angle = (h % 360) * 3.14159f / 180.0f;
-            return cv::Point2f(std::cos(angle), std::sin(angle));
-        };
-        
-        // Get corners
-        cv::Point2f g00 = getGradient(xi, yi);
-        cv::Point2f g10 = getGradient(xi + 1, yi);
-        cv::Point2f g01 = getGradient(xi, yi + 1);
-        cv::Point2f g11 = getGradient(xi + 1, yi + 1);
-        
-        // Dot products
-        float n00 = g00.x * xf + g00.y * yf;
-        float n10 = g10.x * (xf - 1.0f) + g10.y * yf;
-        float n01 = g01.x * xf + g01.y * (yf - 1.0f);
-        float n11 = g11.x * (xf - 1.0f) + g11.y * (yf - 1.0f);
-        
-        // Smoothing function
-        auto fade = [](float t) { return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f); };
-        
-        // Interpolation
-        float u = fade(xf);
-        float v = fade(yf);
-        
-        float nx0 = n00 + u * (n10 - n00);
-        float nx1 = n01 + u * (n11 - n01);
-        float nxy = nx0 + v * (nx1 - nx0);
-        
-        total += nxy * amplitude;
-        maxValue += amplitude;
-        amplitude *= persistence;
-        frequency *= 2.0f;
-    }
-    
-    return total / maxValue;
-}
-
-// Simple implementation of Simplex noise
-float NoiseNode::simplexNoise(float x, float y) {
-    // Constants for 2D simplex noise
-    const float F2 = 0.366025403f; // 0.5*(sqrt(3.0)-1.0)
-    const float G2 = 0.211324865f; // (3.0-sqrt(3.0))/6.0
+cv::Mat NoiseNode::generateWorleyNoise(int width, int height, int channel) {
+    cv::Mat result(height, width, CV_32FC1);
+    if (width <= 0 || height <= 0) return result;
     
-    // Skew input space to determine which simplex cell we're in
-    float s = (x + y) * F2;
-    float xs = x + s;
-    float ys = y + s;
-    int i = static_cast<int>(std::floor(xs));
-    int j = static_cast<int>(std::floor(ys));
+    // Jittered grid with one feature point per cell. Distances are measured
+    // in cells, so the nearest points always lie in the 3x3 neighbourhood.
+    const float cellSize = std::max(width / (scale * 10.0f), 1.0f);
+    const float invCell = 1.0f / cellSize;
+    const int cellsX = static_cast<int>(std::ceil(width * invCell));
+    const int cellsY = static_cast<int>(std::ceil(height * invCell));
     
-    float t = static_cast<float>(i + j) * G2;
-    float X0 = i - t;
-    float Y0 = j - t;
-    float x0 = x - X0;
-    float y0 = y - Y0;
-    
-    // Determine which simplex we're in
-    int i1, j1;
-    if (x0 > y0) {
-        i1 = 1; j1 = 0;
-    } else {
-        i1 = 0; j1 = 1;
+    // Points for every cell plus a one-cell border, in cell units
+    const int stride = cellsX + 2;
+    const uint32_t cellSeed = static_cast<uint32_t>(seed) ^ static_cast<uint32_t>(channel) * 0x68e31da4u;
+    std::vector<float> pointX(static_cast<size_t>(stride) * (cellsY + 2));
+    std::vector<float> pointY(pointX.size());
+    for (int cy = -1; cy <= cellsY; cy++) {
+        for (int cx = -1; cx <= cellsX; cx++) {
+            uint32_t h = cellHash(cx, cy, cellSeed);
+            size_t k = static_cast<size_t>(cy + 1) * stride + (cx + 1);
+            pointX[k] = cx + unitFloat(h);
+            pointY[k] = cy + unitFloat(cellHash(cx, cy, cellSeed ^ 0x9e3779b9u));
+        }
     }
     
-    float x1 = x0 - i1 + G2;
-    float y1 = y0 - j1 + G2;
-    float x2 = x0 - 1.0f + 2.0f * G2;
-    float y2 = y0 - 1.0f + 2.0f * G2;
-    
-    // Simple hash function
-    auto hash = [](int x, int y) {
-        int h = x * 31 + y;
-        h = h ^ (h >> 13);
-        h = h * (h * h * 15731 + 789221) + 1376312589;
-        return h & 0x7fffffff;
-    };
+    const Octaves oct(std::max(octaves, 1), persistence);
+    const int mode = worleyDistance;
     
-    // Calculate contribution from corners
-    auto calcCorner = [](float t, float x, float y) {
-        if (t > 0.0f) {
-            t *= t;
-            return t * t * (x * x + y * y);
+    // Octaves above the first modulate the distance by a ripple,
+    // 0.5 + 0.5 * sin((x + y) * o * step). With sin(a + b) split into
+    // sin a cos b + cos a sin b, the sines are tabled once per column and
+    // once per row instead of being evaluated per pixel and octave.
+    // The ripple is laid out in full-resolution pixels.
+    const float rippleStep = 0.01f / static_cast<float>(proxyScale);
+    const size_t columns = static_cast<size_t>(width);
+    const int ripples = std::max(octaves - 1, 0);
+    std::vector<float> sinX(columns * ripples);
+    std::vector<float> cosX(columns * ripples);
+    float rippleBase = 1.0f;
+    for (int r = 0; r < ripples; r++) {
+        const int o = r + 1;
+        rippleBase += 0.5f * oct.amplitude[o];
+        for (int x = 0; x < width; x++) {
+            sinX[r * columns + x] = std::sin(x * o * rippleStep);
+            cosX[r * columns + x] = std::cos(x * o * rippleStep);
         }
-        return 0.0f;
-    };
-    
-    float n0 = calcCorner(0.5f - x0*x0 - y0*y0, x0, y0);
-    float n1 = calcCorner(0.5f - x1*x1 - y1*y1, x1, y1);
-    float n2 = calcCorner(0.5f - x2*x2 - y2*y2, x2, y2);
-    
-    // Scale to [-1,1]
-    return 70.0f * (n0 + n1 + n2);
-}
-
-// Worley noise is fully implemented in generateWorleyNoise
-float NoiseNode::worleyNoise(float x, float y) {
-    return 0.0f; // Not used directly - see generateWorleyNoise
-}
-
-cv::Mat NoiseNode::applyDisplacementMap(const cv::Mat& inputImage, const cv::Mat& noiseMap) {
-    // Resize noise map to match input image if needed
-    cv::Mat resizedNoise;
-    if (noiseMap.size() != inputImage.size()) {
-        cv::resize(noiseMap, resizedNoise, inputImage.size(), 0, 0, cv::INTER_LINEAR);
-    } else {
-        resizedNoise = noiseMap.clone();
     }
     
-    // Create output image
-    cv::Mat result = inputImage.clone();
-    
-    // Apply displacement map
-    for (int y = 0; y < inputImage.rows; y++) {
-        for (int x = 0; x < inputImage.cols; x++) {
-            // Get displacement values from noise (use only R channel since it's grayscale)
-            float displaceX = (resizedNoise.at<cv::Vec3b>(y, x)[0] / 255.0f - 0.5f) * 10.0f;
-            float displaceY = (resizedNoise.at<cv::Vec3b>(y, x)[0] / 255.0f - 0.5f) * 10.0f;
-            
-            // Calculate source coordinates
-            int srcX = static_cast<int>(x + displaceX);
-            int srcY = static_cast<int>(y + displaceY);
+    cv::parallel_for_(cv::Range(0, height), [&](const cv::Range& rows) {
+        std::vector<float> ripple(columns);
+        
+        for (int y = rows.start; y < rows.end; y++) {
+            const float py = y * invCell;
+            const int cy = std::min(static_cast<int>(py), cellsY - 1);
+            float* out = result.ptr<float>(y);
             
-            // Clamp to image boundaries
-            srcX = std::max(0, std::min(srcX, inputImage.cols - 1));
-            srcY = std::max(0, std::min(srcY, inputImage.rows - 1));
+            // Octave weight of every pixel in the row, divided by the total
+            // amplitude
+            std::fill(ripple.begin(), ripple.end(), rippleBase / oct.total);
+            for (int r = 0; r < ripples; r++) {
+                const int o = r + 1;
+                const float weight = 0.5f * oct.amplitude[o] / oct.total;
+                const float a = weight * std::cos(y * o * rippleStep);
+                const float b = weight * std::sin(y * o * rippleStep);
+                const float* sinRow = &sinX[r * columns];
+                const float* cosRow = &cosX[r * columns];
+                for (int x = 0; x < width; x++) {
+                    ripple[x] += a * sinRow[x] + b * cosRow[x];
+                }
+            }
             
-            // Copy pixel value
-            result.at<cv::Vec3b>(y, x) = inputImage.at<cv::Vec3b>(srcY, srcX);
+            for (int x = 0; x < width; x++) {
+                const float px = x * invCell;
+                const int cx = std::min(static_cast<int>(px), cellsX - 1);
+                
+                // Two smallest squared distances over the neighbourhood
+                float f1 = std::numeric_limits<float>::max();
+                float f2 = std::numeric_limits<float>::max();
+                for (int ny = cy; ny <= cy + 2; ny++) {
+                    const float* rowX = &pointX[static_cast<size_t>(ny) * stride];
+                    const float* rowY = &pointY[static_cast<size_t>(ny) * stride];
+                    for (int nx = cx; nx <= cx + 2; nx++) {
+                        float dx = rowX[nx] - px;
+                        float dy = rowY[nx] - py;
+                        float d = dx * dx + dy * dy;
+                        f2 = std::max(f1, std::min(f2, d));
+                        f1 = std::min(f1, d);
+                    }
+                }
+                
+                float distance;
+                switch (mode) {
+                    case 1:  distance = std::sqrt(f2); break;
+                    case 2:  distance = std::sqrt(f2) - std::sqrt(f1); break;
+                    default: distance = std::sqrt(f1); break;
+                }
+                out[x] = toUnit(std::min(distance, 1.0f) * ripple[x]);
+            }
         }
-    }
+    });
     
     return result;
 }
+
+// amplitude: largest offset in pixels, at the resolution of inputImage.
+// The noise maps are stretched over the image and turned into absolute
+// sampling positions, then cv::remap samples the input bilinearly; it
+// handles every depth and channel count and splits rows over its workers.
+cv::Mat NoiseNode::applyDisplacementMap(const cv::Mat& inputImage, const cv::Mat& noiseX,
+                                        const cv::Mat& noiseY, float amplitude) {
+    cv::Mat offsetX = noiseX, offsetY = noiseY;
+    if (noiseX.size() != inputImage.size()) cv::resize(noiseX, offsetX, inputImage.size(), 0, 0, cv::INTER_LINEAR);
+    if (noiseY.size() != inputImage.size()) cv::resize(noiseY, offsetY, inputImage.size(), 0, 0, cv::INTER_LINEAR);
+
+    // Noise value v moves the sample by (v - 0.5) * amplitude
+    cv::Mat mapX(inputImage.size(), CV_32FC1);
+    cv::Mat mapY(inputImage.size(), CV_32FC1);
+    const float gain = amplitude;
+    const float bias = -0.5f * amplitude;
+    cv::parallel_for_(cv::Range(0, inputImage.rows), [&](const cv::Range& rows) {
+        for (int y = rows.start; y < rows.end; y++) {
+            const float* nx = offsetX.ptr<float>(y);
+            const float* ny = offsetY.ptr<float>(y);
+            float* mx = mapX.ptr<float>(y);
+            float* my = mapY.ptr<float>(y);
+            const float fy = static_cast<float>(y) + bias;
+            for (int x = 0; x < inputImage.cols; x++) {
+                mx[x] = static_cast<float>(x) + bias + nx[x] * gain;
+                my[x] = fy + ny[x] * gain;
+            }
+        }
+    });
+
+    // Samples past the edge repeat the border, as the former clamping did
+    cv::Mat result;
+    cv::remap(inputImage, result, mapX, mapY, cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+    return result;
+}
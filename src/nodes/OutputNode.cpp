@@ -1,123 +1,197 @@
 #include "nodes/OutputNode.hpp"
+#include "ImageEncoder.hpp"
 #include <imgui.h>
 #include "portable-file-dialogs.h"
 #include <opencv2/imgcodecs.hpp>
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
+#include <iostream>
 
 
 OutputNode::OutputNode() {
     name = "Output";
     inputs.emplace_back(Pin{0, "Image"});
-    glGenTextures(1, &textureID);
 }
 
-OutputNode::~OutputNode() {
-    if (textureID != 0) {
-        glDeleteTextures(1, &textureID);
-    }
+OutputNode::OutputNode(const OutputNode& other)
+    : BaseNode(other),
+      filepath(other.filepath),
+      format(other.format),
+      quality(other.quality),
+      compression(other.compression),
+      halfFloat(other.halfFloat),
+      preview(other.preview),
+      previewVersion(other.previewVersion),
+      previewPending(other.previewPending) {
 }
 
+OutputNode::~OutputNode() = default;
+
 void OutputNode::process() {
     if (inputs.empty() || inputs[0].data.empty()) return;
 
-    cv::Mat processedImage;
-    if (inputs[0].data.channels() == 1) {
-        cv::cvtColor(inputs[0].data, processedImage, cv::COLOR_GRAY2BGR);
+    // No GL calls here: this is executed by the graph's worker threads.
+    // Without a preview backend (headless) there is nothing to prepare.
+    if (!PreviewTexture::available()) return;
+
+    // Unchanged content since the last preview: nothing to upload
+    const Pin& input = inputs[0];
+    if (input.version != 0 && input.version == previewVersion && !preview.empty()) return;
+
+    // 8- and 16-bit images are shown as they are, sharing the input buffer;
+    // drawUI() picks texture coordinates that account for GL's bottom-up row
+    // order instead of flipping the pixels. Gray is uploaded as gray, and a
+    // lone color channel is expanded here, on the worker. Floating point is
+    // converted to half floats: half the upload of float, without the
+    // banding of rounding to 8 bits.
+    const cv::Mat image = result();
+    if (image.depth() == CV_8U || image.depth() == CV_16U) {
+        preview = image;
+    } else if (image.depth() == CV_32F || image.depth() == CV_64F) {
+        cv::Mat half;
+        image.convertTo(half, CV_16F);
+        preview = half;
     } else {
-        processedImage = inputs[0].data.clone();
+        preview = convertDepth(image, CV_8U);
     }
+    previewVersion = input.version;
+    previewPending = true;
+}
 
-    cv::flip(processedImage, processedImage, 0);
+void OutputNode::uploadPreview() {
+    if (!previewPending || preview.empty()) return;
 
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 
-                processedImage.cols, processedImage.rows, 0,
-                GL_BGR, GL_UNSIGNED_BYTE, processedImage.data);
+    if (!texture) {
+        texture = PreviewTexture::create();
+        if (!texture) return;
+    }
+
+    texture->upload(preview);
+    previewPending = false;
 }
 
 void OutputNode::drawUI() {
     ImGui::Text("Output Settings");
     
-    const char* formats[] = {"PNG", "JPEG", "BMP"};
+    const char* formats[] = {"PNG", "JPEG", "BMP", "TIFF (uncompressed)", "OpenEXR"};
     ImGui::Combo("Format", &format, formats, IM_ARRAYSIZE(formats));
 
     if (format == 1) { // JPEG
         ImGui::SliderInt("Quality", &quality, 1, 100);
     } else if (format == 0) { // PNG
         ImGui::SliderInt("Compression", &compression, 0, 9);
+    } else if (format == 4) {
+        ImGui::Checkbox("Half Float", &halfFloat);
     }
 
     if (ImGui::Button("Save Image")) {
-        auto file = pfd::save_file("Save image", "",
-            { "Image Files", "*.png *.jpg *.jpeg *.bmp" });
+        auto file = pfd::save_file("Save image", filepath,
+            { "Image Files", "*.png *.jpg *.jpeg *.bmp *.tif *.tiff *.exr" });
         if (!file.result().empty()) {
             saveImage(file.result());
         }
     }
+    drawSaveStatus();
+
+    if (proxyScale < 1.0) {
+        ImGui::TextDisabled("Preview at 1/%d resolution", static_cast<int>(std::lround(1.0 / proxyScale)));
+    }
 
-    if (!inputs[0].data.empty() && textureID != 0) {
+    uploadPreview();
+
+    if (!inputs[0].data.empty() && texture) {
         float aspect = static_cast<float>(inputs[0].data.rows) / inputs[0].data.cols;
-        ImGui::Image((ImTextureID)(intptr_t)textureID, 
+        // Image rows are uploaded top first, so texture coordinates run top-down
+        ImGui::Image(texture->id(), 
                     ImVec2(300, 300 * aspect),
-                    ImVec2(0, 1), ImVec2(1, 0));
+                    ImVec2(0, 0), ImVec2(1, 1));
+    }
+
+    // Luminance of the result; shared with any other reader of the same image
+    if (!inputs[0].data.empty() && ImGui::CollapsingHeader("Histogram")) {
+        std::shared_ptr<const ImageStats> stats = inputs[0].stats();
+        const std::array<float, ImageStats::kBins> bins = stats->normalized();
+        ImGui::PlotHistogram("##histogram", bins.data(), ImageStats::kBins, 0, nullptr,
+                             0.0f, 1.0f, ImVec2(300, 60));
+        const double toUnit = 1.0 / depthMax(stats->depth);
+        ImGui::Text("Min %.3f  Max %.3f  Mean %.3f", stats->min * toUnit, stats->max * toUnit,
+                    stats->mean() * toUnit);
     }
 }
 
 
 
-void OutputNode::saveImage(const std::string& path) {
+bool OutputNode::saveImage(const std::string& path) {
     if (inputs.empty() || inputs[0].data.empty()) {
-        std::cerr << "ERROR: No input image to save!\n";
-        return;
+        saveStatus = "Nothing to save yet";
+        return false;
+    }
+    if (proxyScale < 1.0) {
+        saveStatus = "Full-resolution pass still running; try again shortly";
+        return false;
     }
-
-    // Debug: Print image properties
-    std::cout << "\n--- Saving Image Debug Info ---\n"
-              << "Dimensions: " << inputs[0].data.cols << "x" 
-              << inputs[0].data.rows << "\n"
-              << "Channels: " << inputs[0].data.channels() << "\n"
-              << "Data pointer: " << inputs[0].data.data << "\n";
-
-    // Undo OpenGL's vertical flip
-    cv::Mat saveImage;
-    cv::flip(inputs[0].data, saveImage, 0); // 0 = vertical flip
 
     // Add file extension if missing
-    std::string fullPath = path;
-    const char* extensions[] = {".png", ".jpg", ".bmp"};
-    if (fullPath.find('.') == std::string::npos) {
-        fullPath += extensions[format];
+    std::filesystem::path target(path);
+    if (!target.has_extension()) target += fileExtension();
+    filepath = target.string();
+
+    // Encoding a large PNG takes seconds, so it happens off the UI thread
+    pendingSave = ImageEncoder::shared().submit({filepath, result(), encodeParams()});
+    saveStatus = "Saving " + target.filename().string() + "...";
+    return true;
+}
+
+void OutputNode::drawSaveStatus() {
+    if (pendingSave.valid() &&
+        pendingSave.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        bool ok = pendingSave.get();
+        saveStatus = (ok ? "Saved " : "Could not write ") + filepath;
     }
+    if (!saveStatus.empty()) ImGui::Text("%s", saveStatus.c_str());
+}
 
-    // Create parent directories
-    std::filesystem::create_directories(
-        std::filesystem::path(fullPath).parent_path()
-    );
 
-    // Set OpenCV write parameters
-    std::vector<int> params;
-    switch(format) {
-        case 0: params = {cv::IMWRITE_PNG_COMPRESSION, compression}; break;
-        case 1: params = {cv::IMWRITE_JPEG_QUALITY, quality}; break;
-        default: break;
-    }
+std::string OutputNode::fileExtension() const {
+    const char* extensions[] = {".png", ".jpg", ".bmp", ".tif", ".exr"};
+    return extensions[format];
+}
 
-    // Attempt to save
-    bool success = cv::imwrite(fullPath, saveImage, params);
-    
-    std::cout << "Save " << (success ? "SUCCEEDED" : "FAILED") 
-              << " at: " << fullPath << "\n";
-
-    if (!success) {
-        std::cerr << "Possible reasons:\n"
-                  << "1. Invalid path/permissions\n"
-                  << "2. Unsupported format\n"
-                  << "3. Corrupted image data\n";
+// OpenCV write parameters for the selected format
+std::vector<int> OutputNode::encodeParams() const {
+    switch(format) {
+        case 0: return {cv::IMWRITE_PNG_COMPRESSION, compression};
+        case 1: return {cv::IMWRITE_JPEG_QUALITY, quality};
+        case 3: return {cv::IMWRITE_TIFF_COMPRESSION, 1}; // No compression: fastest to write and read back
+        case 4: return {cv::IMWRITE_EXR_TYPE, halfFloat ? cv::IMWRITE_EXR_TYPE_HALF : cv::IMWRITE_EXR_TYPE_FLOAT};
+        default: return {};
     }
 }
 
-
 int OutputNode::getPinType(int pinId) const {
     return 0; // All pins are image type
 }
+
+BaseNode* OutputNode::clone() const {
+    return new OutputNode(*this); // The texture stays owned by this node
+}
+
+void OutputNode::serializeParams(ParamArchive& ar) {
+    ar.field("filepath", filepath);
+    ar.field("format", format);
+    ar.field("quality", quality);
+    ar.field("compression", compression);
+    ar.field("halfFloat", halfFloat);
+    // format indexes the extension table; a damaged or newer file must not
+    // read past it
+    if (ar.loading()) format = std::min(std::max(format, 0), 4);
+}
+
+void OutputNode::adoptResults(const BaseNode& evaluated) {
+    BaseNode::adoptResults(evaluated);
+    const auto& result = static_cast<const OutputNode&>(evaluated);
+    preview = result.preview;
+    previewVersion = result.previewVersion;
+    previewPending = result.previewPending;
+}
@@ -19,41 +19,60 @@ ThresholdNode::ThresholdNode() {
 int ThresholdNode::getPinType(int pinId) const {
     return 0; // Image type
 }
-/**
- *  Calculates the histogram of the input image
- * 
- * This method computes a 256-bin histogram of pixel intensities
- * from the input grayscale image. If the input is a color image,
- * it's converted to grayscale first.
- */
 
-// ThresholdNode.cpp
-void ThresholdNode::calculateHistogram() {
-    if (inputs.empty() || inputs[0].data.empty()) return;
+BaseNode* ThresholdNode::clone() const {
+    return new ThresholdNode(*this);
+}
 
-    // Convert to grayscale if needed
-    cv::Mat gray;
-    if (inputs[0].data.channels() == 3) {
-        cv::cvtColor(inputs[0].data, gray, cv::COLOR_BGR2GRAY);
-    } else {
-        gray = inputs[0].data.clone();
-    }
+void ThresholdNode::serializeParams(ParamArchive& ar) {
+    ar.field("method", method);
+    ar.field("thresholdValue", thresholdValue);
+    ar.field("outputType", outputType);
+}
 
-    // Calculate histogram
-    const int histSize = 256;
-    const float range[] = {0, 256};
-    const float* histRange = {range};
-    
-    cv::Mat hist;
-    cv::calcHist(&gray, 1, 0, cv::Mat(), hist, 1, &histSize, &histRange);
+int ThresholdNode::tileHalo() const {
+    switch(method) {
+        case 1: return 11 / 2; // Adaptive: 11x11 neighbourhood
+        case 2: return -1;     // Otsu: threshold depends on the whole histogram
+        default: return 0;
+    }
+}
+bool ThresholdNode::pointwiseLut(int channels, cv::Mat& lut, bool& toGray) const {
+    if (method != 0) return false;
 
-    // Store in member variable
-    histogram.resize(histSize);
-    for (int i = 0; i < histSize; i++) {
-        histogram[i] = hist.at<float>(i);
+    // cv::threshold compares 8-bit pixels against the floored threshold
+    const int limit = cvFloor(thresholdValue);
+    lut.create(1, 256, CV_8U);
+    unsigned char* table = lut.ptr<unsigned char>();
+    for (int i = 0; i < 256; i++) {
+        table[i] = i > limit ? 255 : 0;
     }
+    toGray = channels == 3;
+    return true;
 }
 
+/**
+ * Shows the histogram of the input, with its range, mean and the value Otsu
+ * would pick. The statistics belong to the input pin and are shared with
+ * process() and every other reader of the same image, so they are gathered
+ * once per image; while editing, that image is usually a small proxy.
+ * Inside a fused chain the input is produced only for this display (see
+ * showsInput()).
+ */
+void ThresholdNode::drawHistogram() {
+    if (inputs.empty() || inputs[0].data.empty()) return;
+    std::shared_ptr<const ImageStats> stats = inputs[0].stats();
+    if (!stats || stats->count == 0) return;
+
+    // Values are shown in 8-bit steps, like the threshold slider
+    const double toSlider = 255.0 / depthMax(stats->depth);
+    const std::array<float, ImageStats::kBins> bins = stats->normalized();
+    ImGui::PlotHistogram("##histogram", bins.data(), ImageStats::kBins, 0, nullptr,
+                         0.0f, 1.0f, ImVec2(0, 60));
+    ImGui::Text("Min %.1f  Max %.1f  Mean %.1f", stats->min * toSlider, stats->max * toSlider,
+                stats->mean() * toSlider);
+    ImGui::TextDisabled("Otsu: %.1f", stats->otsuThreshold() * toSlider);
+}
 
 /**
  *Processes the input image with the selected thresholding method
@@ -66,39 +85,41 @@ void ThresholdNode::calculateHistogram() {
 
 void ThresholdNode::process() {
     if(inputs[0].data.empty()) return;
-    // Convert to grayscale if needed (thresholding requires grayscale input)
-    cv::Mat gray;
-    if (inputs[0].data.channels() == 3) {
-        cv::cvtColor(inputs[0].data, gray, cv::COLOR_BGR2GRAY);
-    } else {
-        gray = inputs[0].data.clone();
-    }
+    // Thresholding requires grayscale input; the conversion is made once per upstream image
+    cv::Mat gray = inputs[0].gray();
     
+    // The value is in 8-bit steps; simple thresholds are taken at the image's
+    // own depth, while adaptive thresholding, which OpenCV runs on 8 bits
+    // only, sees an 8-bit copy and its mask is brought back to the image's depth
+    const int depth = gray.depth();
+    const double scale = depthMax(depth) / 255.0;
     cv::Mat thresholded;
     switch(method) {
-        case 1: // Adaptive
-            cv::adaptiveThreshold(gray, thresholded, 255, 
-                cv::ADAPTIVE_THRESH_GAUSSIAN_C, cv::THRESH_BINARY, 11, 2);
+        case 1: // Adaptive; the 11 px neighbourhood shrinks with a proxy, but stays odd
+            cv::adaptiveThreshold(convertDepth(gray, CV_8U), thresholded, 255, 
+                cv::ADAPTIVE_THRESH_GAUSSIAN_C, cv::THRESH_BINARY, proxyPixels(11, 3) | 1, 2);
             break;
-        case 2: // Otsu
-            cv::threshold(gray, thresholded, 0, 255, 
-                cv::THRESH_BINARY | cv::THRESH_OTSU);
+        case 2: // Otsu, from the histogram shared with the UI and other readers
+            cv::threshold(gray, thresholded, inputs[0].stats()->otsuThreshold(), depthMax(depth),
+                cv::THRESH_BINARY);
             break;
         default: // Simple
-            cv::threshold(gray, thresholded, thresholdValue, 255, 
+            cv::threshold(gray, thresholded, thresholdValue * scale, depthMax(depth), 
                 cv::THRESH_BINARY);
     }
     
-    outputs[0].data = thresholded;
+    outputs[0].data = convertDepth(thresholded, depth);
 }
 
 void ThresholdNode::drawUI() {
     const char* methods[] = {"Binary", "Binary Inv", "Trunc", "To Zero", "To Zero Inv"};
-    ImGui::Combo("Method", &method, methods, IM_ARRAYSIZE(methods));
+    dirty |= ImGui::Combo("Method", &method, methods, IM_ARRAYSIZE(methods));
     
-    ImGui::SliderFloat("Value", &thresholdValue, 0.0f, 255.0f);
+    dirty |= ImGui::SliderFloat("Value", &thresholdValue, 0.0f, 255.0f);
     
     const char* types[] = {"8UC1", "32FC1"};
-    ImGui::Combo("Type", &outputType, types, IM_ARRAYSIZE(types)); // Now valid
+    dirty |= ImGui::Combo("Type", &outputType, types, IM_ARRAYSIZE(types)); // Now valid
+
+    drawHistogram();
 }
 